@@ -2,8 +2,8 @@
  * Emulador de Dispositivo Anviz para NodeMCU/ESP8266
  * 
  * Este código implementa un emulador de dispositivo de control de acceso Anviz
- * que puede ser utilizado con el software CrossChex. Soporta un lector RFID Wiegand 26/34
- * para control de acceso con tarjetas.
+ * que puede ser utilizado con el software CrossChex. Soporta varios lectores RFID Wiegand
+ * 26/34/35/37/48 (de entrada o de salida) para control de acceso con tarjetas.
  * 
  * Autor: Oemspot
  * Fecha: 03-11-2025
@@ -17,6 +17,7 @@
 #include <NTPClient.h>
 #include <WiFiUdp.h>
 #include <WiFiManager.h>
+#include <PubSubClient.h>
 
 // ========= CONFIGURACIÓN WIFI Y RED ==========
 
@@ -36,19 +37,33 @@
 #define ACK_NO_USER 0x06   // Usuario no encontrado
 #define ACK_TIME_OUT 0x08  // Tiempo de espera agotado
 
-// ========= VARIABLES WIEGAND ===========
-volatile unsigned long wiegandData = 0;      // Datos Wiegand recibidos
-volatile byte wiegandBitCount = 0;           // Contador de bits recibidos
-volatile unsigned long wiegandTimeoutStart = 0; // Tiempo de inicio para timeout
-#define WIEGAND_TIMEOUT 25  // Timeout en milisegundos
-
 // Incluir los archivos de cabecera
 #include "estructuras.h"
 #include "variables.h"
+#include "diagnostico.h"
+#include "indices.h"
+#include "diario.h"
+#include "registros.h"
+#include "descargas.h"
+#include "asistencia.h"
+#include "horarios.h"
+#include "antipassback.h"
+#include "denegaciones.h"
+#include "rangos.h"
+#include "lectores.h"
+#include "respuestas.h"
+#include "metricas.h"
+#include "sesion.h"
 #include "protocolo.h"
+#include "assets.h"
+#include "importacion.h"
 #include "web.h"
 #include "utilidades.h"
+#include "envio.h"
 #include "almacenamiento.h"
+#include "api.h"
+#include "eventos.h"
+#include "mqtt.h"
 
 // ========= VARIABLES PARA MANEJO NO BLOQUEANTE ===========
 LedState currentLedState = LED_IDLE;
@@ -56,23 +71,6 @@ unsigned long actionStartTime = 0;
 unsigned long ledBlinkTime = 0;
 int blinkCount = 0;
 
-// ========= MANEJADORES DE INTERRUPCIÓN PARA WIEGAND ===========
-ICACHE_RAM_ATTR void handleD0() {
-  wiegandTimeoutStart = millis();
-  if (wiegandBitCount < 34) {
-    wiegandBitCount++;
-    wiegandData = wiegandData << 1;  // Shift left y agregar 0
-  }
-}
-
-ICACHE_RAM_ATTR void handleD1() {
-  wiegandTimeoutStart = millis();
-  if (wiegandBitCount < 34) {
-    wiegandBitCount++;
-    wiegandData = (wiegandData << 1) | 1;  // Shift left y agregar 1
-  }
-}
-
 // Función mejorada para conectar al WiFi
 bool connectWiFi() {
   WiFiManager wifiManager;
@@ -98,6 +96,7 @@ bool connectWiFi() {
 void setup() {
   Serial.begin(115200);
   Serial.println("\n\n[SETUP] Iniciando emulador de dispositivo Anviz...");
+  resetMemProfiles();
 
   // Inicializar sistema de archivos
   if (!SPIFFS.begin()) {
@@ -115,16 +114,22 @@ void setup() {
   // Cargar datos almacenados
   loadConfig();
   loadWebAuth();
+  loadSchedules();
+  loadCardRanges();
   loadUsers();
   loadRecords();
+  loadAttendance();
+  loadPushConfig();
+  loadPushCursor();
+  loadDownloadCursors();
+  loadMqttConfig();
+  setupMqtt();
   Serial.println("[SETUP] Carga de datos finalizada.");
   
   // Inicializar hardware AHORA que tenemos la configuración de pines cargada
   Serial.println("[SETUP] Configurando pines de hardware...");
   pinMode(basicConfig.pin_relay, OUTPUT);
   pinMode(basicConfig.pin_led, OUTPUT);
-  pinMode(basicConfig.pin_d0, INPUT_PULLUP);  // Wiegand Data0
-  pinMode(basicConfig.pin_d1, INPUT_PULLUP);  // Wiegand Data1
   
   digitalWrite(basicConfig.pin_relay, LOW);
   digitalWrite(basicConfig.pin_led, LOW);
@@ -139,8 +144,7 @@ void setup() {
   
   // Configurar interrupciones para Wiegand
   Serial.println("[SETUP] Configurando interrupciones Wiegand...");
-  attachInterrupt(digitalPinToInterrupt(basicConfig.pin_d0), handleD0, FALLING);
-  attachInterrupt(digitalPinToInterrupt(basicConfig.pin_d1), handleD1, FALLING);
+  setupWiegandReaders();
   Serial.println("[SETUP] Interrupciones Wiegand activadas.");
   
   // Conectar a WiFi con el método mejorado
@@ -175,30 +179,56 @@ void setup() {
 
 // ========= LOOP PRINCIPAL ===========
 void loop() {
+  unsigned long loopStart = micros();
+
   // Heartbeat para saber que el loop está corriendo
   static unsigned long lastHeartbeat = 0;
   const unsigned long heartbeatInterval = 10000; // 10 segundos
   if (millis() - lastHeartbeat > heartbeatInterval) {
     lastHeartbeat = millis();
+    memProfileSample(); // Muestra periódica de memoria en reposo
     String uptime = String(millis() / 60000);
     Serial.println("[HEARTBEAT] System OK. Uptime: " + uptime + " min. | millis: " + String(millis()) + " | lastHeartbeat: " + String(lastHeartbeat));
   }
 
-  // Atender servidor web
+  // Decidir primero sobre cualquier tarjeta ya leída, antes del trabajo web
+  checkWiegandCard();
+  handleLedAndRelay();
+
+  // Atender servidor web. Los manejadores solo validan y registran la
+  // respuesta; las páginas largas se generan por partes en pumpHttpStreams().
+  // El perfil de memoria solo se abre si llega una petición (web.h).
   webServer.handleClient();
+  endWebRequestProfile();
+  pumpHttpStreams();
+
+  // Enviar eventos pendientes a los suscriptores SSE (no bloqueante)
+  pumpEventSubscribers();
+
+  // Enviar registros nuevos al colector, si está configurado
+  pumpPush();
+
+  // Guardar los cursores de descarga confirmados (como mucho cada 10 s)
+  pumpDownloadCursors();
+
+  // MQTT: eventos pendientes, latido y órdenes remotas
+  pumpMqtt();
   
-  // Revisar si hay cliente TCP nuevo
-  WiFiClient newClient = server.available();
-  if (newClient) {
-    if (!client || !client.connected()) {
-      client = newClient;
-      Serial.println("Nuevo cliente TCP conectado");
-    }
-  }
+  // Sesión TCP: aceptar conexiones, cerrar las muertas o inactivas y enviar
+  // lo que quepa de las respuestas pendientes
+  pumpSession();
+
+  // Tramas pendientes de una respuesta masiva de 0x40/0x42
+  pumpBulkStream();
   
-  // Procesar comandos TCP si hay cliente conectado
-  if (client && client.connected() && client.available() > 0) {
-    processAnvizCommand();
+  // Procesar comandos TCP si hay sesión. Si la cola no admite otra respuesta
+  // completa, el comando espera en el búfer de recepción.
+  if (sessionActive && client.available() > 0) {
+    if (sessionCanAccept()) {
+      processAnvizCommand();
+    } else {
+      metrics.txBackpressure++;
+    }
   }
   
   // Revisar si hay tarjeta Wiegand
@@ -213,6 +243,7 @@ void loop() {
     lastWifiCheck = millis();
     if (WiFi.status() != WL_CONNECTED) {
       Serial.println("Conexión WiFi perdida, intentando reconectar...");
+      metrics.wifiReconnects++;
       // Parpadear LED para indicar reconexión
       digitalWrite(basicConfig.pin_led, HIGH);
       delay(200);
@@ -240,6 +271,9 @@ void loop() {
     lastSaveTime = millis();
   }
 
+  // Medir la duración de la iteración (sin contar la pausa final)
+  recordLoopDuration(micros() - loopStart);
+
   delay(10); // Pequeño delay para dar tiempo a otros procesos
 }
 
@@ -272,18 +306,34 @@ void initializeDefaultConfig() {
   basicConfig.languageFlag = 0x10;
   basicConfig.cmdVersion = 0x02;
 
-  // Pines por defecto
-  basicConfig.pin_d0 = D7;
-  basicConfig.pin_d1 = D6;
+  // Pines por defecto: un único lector de entrada
+  basicConfig.readers[0].pin_d0 = D7;
+  basicConfig.readers[0].pin_d1 = D6;
+  basicConfig.readers[0].direction = 0;
+  basicConfig.readerCount = 1;
   basicConfig.pin_relay = D1;
   basicConfig.pin_led = D0;
   basicConfig.relayOnDuration = 2000; // 2 segundos por defecto
+
+  // Lecturas repetidas: descartar durante 3 segundos; anti-passback desactivado
+  basicConfig.duplicateWindow = 3000;
+  basicConfig.antiPassbackTime = 0;
+
+  // Sesión TCP: cerrar tras 5 minutos sin comandos; sondear a los 30 s sin tráfico
+  basicConfig.sessionIdleTimeout = 300;
+  basicConfig.keepAliveIdle = 30;
+  basicConfig.bulkPages = 1; // Las peticiones masivas reciben también una sola trama
   
   // Número de serie por defecto
   strcpy(serialNumber, SERIAL_NUMBER);
 }
 
 void setupWebServer() {
+  // Cabeceras que necesitan los manejadores (Authorization se recoge siempre)
+  static const char* headerKeys[] = { "If-None-Match" };
+  webServer.collectHeaders(headerKeys, 1);
+  webServer.addHook(webRequestHook);
+
   // Rutas del servidor web
   webServer.on("/", HTTP_GET, handleRoot);
   webServer.on("/users", HTTP_GET, handleUsers);
@@ -292,76 +342,174 @@ void setupWebServer() {
   webServer.on("/savesettings", HTTP_POST, handleSaveSettings);
   webServer.on("/auth", HTTP_GET, handleAuth);
   webServer.on("/saveauth", HTTP_POST, handleSaveAuth);
+  webServer.on("/schedule", HTTP_GET, handleSchedule);
+  webServer.on("/saveschedule", HTTP_POST, handleSaveSchedule);
   webServer.on("/changewifi", HTTP_GET, handleWifiChange);
   webServer.on("/clearlogs", HTTP_GET, handleClearLogs);
   webServer.on("/reset", HTTP_GET, handleReset);
+
+  // Recursos estáticos comprimidos (assets.h)
+  webServer.on("/app.css", HTTP_GET, handleAppCss);
+  webServer.on("/app.js", HTTP_GET, handleAppJs);
+
+  // API REST (JSON paginado)
+  webServer.on("/api/status", HTTP_GET, handleApiStatus);
+  webServer.on("/api/users", HTTP_GET, handleApiUsers);
+  webServer.on("/api/users/changes", HTTP_GET, handleApiUserChanges);
+  webServer.on("/api/records", HTTP_GET, handleApiRecords);
+  webServer.on("/api/attendance", HTTP_GET, handleApiAttendance);
+  webServer.on("/api/denials", HTTP_GET, handleApiDenials);
+  webServer.on("/api/ranges", HTTP_GET, handleApiRanges);
+  webServer.on("/api/ranges", HTTP_POST, handleApiCreateRange);
+  webServer.on("/api/ranges/set", HTTP_POST, handleApiSetRange);
+  webServer.on("/api/ranges/delete", HTTP_POST, handleApiDeleteRange);
+  webServer.on("/export/records.csv", HTTP_GET, handleExportRecordsCsv);
+  webServer.on("/events", HTTP_GET, handleEvents);
+  webServer.on("/metrics", HTTP_GET, handleMetrics);
   
   // Rutas para operaciones de mantenimiento
-  webServer.on("/upload", HTTP_POST, []() {
-    webServer.send(200, "text/plain", "Datos recibidos");
-  }, handleFileUpload);
+  webServer.on("/upload", HTTP_POST, handleUploadDone, handleFileUpload);
 }
 
 // ========= FUNCIÓN PARA SINCRONIZACIÓN DE TIEMPO ===========
 void setInternalTime() {
-  // Convertir tiempo NTP a estructura time_t
+  // Convertir tiempo NTP a estructura time_t. Sin respuesta del servidor
+  // NTPClient cuenta desde 1970: no pisar una hora válida con ella.
   time_t epochTime = timeClient.getEpochTime();
+  if (epochTime < (time_t)CLOCK_MIN_VALID_TIME) {
+    Serial.println("NTP sin respuesta, el reloj no se modifica");
+    return;
+  }
   setTime(epochTime);
 }
 
 // ========= FUNCIÓN PARA VERIFICAR TARJETAS WIEGAND ===========
+// Todos los lectores comparten esta decisión. Se atiende una tarjeta a la
+// vez: mientras el LED y el relé están ocupados, las tramas esperan en la
+// cola de su lector (lectores.h) en lugar de perderse.
 void checkWiegandCard() {
-  // Verificar si se ha recibido una tarjeta completa (timeout después del último bit)
-  // Esta condición se evalúa en cada ciclo del loop()
-  if (wiegandBitCount > 0 && millis() - wiegandTimeoutStart > WIEGAND_TIMEOUT) {
-    uint32_t cardId = 0;
-    
-    if (wiegandBitCount == 26) { // Wiegand 26
-      // Extraer el número de tarjeta (ignorando bits de paridad)
-      cardId = (wiegandData >> 1) & 0xFFFFFF;
-    } 
-    else if (wiegandBitCount == 34) { // Wiegand 34
-      // Extraer el número de tarjeta (ignorando bits de paridad)
-      cardId = (wiegandData >> 1) & 0xFFFFFFFF;
-    }
-    
-    Serial.print("\n[WIEGAND] Tarjeta detectada: 0x");
-    Serial.println(cardId, HEX);
+  captureWiegandFrames();
+  if (currentLedState != LED_IDLE) return;
+
+  uint8_t reader;
+  WiegandFrame frame;
+  if (!nextWiegandFrame(reader, frame)) return;
+
+  // Decodificar según la longitud (formatos en lectores.h). Las tramas con
+  // ruido o de formatos no soportados se descartan sin llegar a la decisión.
+  uint32_t cardId = 0;
+  WiegandDecodeResult decoded = decodeWiegandFrame(frame, cardId);
+  if (decoded != WIEGAND_DECODED) {
+    if (decoded == WIEGAND_BAD_PARITY) metrics.wiegandParityErrors++;
+    else if (decoded == WIEGAND_ID_TOO_WIDE) metrics.wiegandWideIds++;
+    else metrics.wiegandUnknownFormats++;
+    Serial.print("[WIEGAND] Trama descartada, bits: ");
+    Serial.println(frame.bits);
+    return;
+  }
+  
+  // Lecturas repetidas de la misma tarjeta (p. ej. apoyada en el lector):
+  // se descartan antes de buscar el usuario o crear ningún registro
+  if (suppressDuplicateSwipe(cardId)) {
+    metrics.swipesSuppressed++;
+    return;
+  }
+  
+  Serial.print("\n[WIEGAND] Tarjeta detectada en lector ");
+  Serial.print(reader);
+  Serial.print(": 0x");
+  Serial.println(cardId, HEX);
+  
+  // Tipo de registro: bit 7 = acceso correcto, bits bajos = sentido del lector
+  uint8_t direction = 0x80 | basicConfig.readers[reader].direction;
+  
+  // Buscar usuario por tarjeta. Las tarjetas desconocidas vistas hace poco
+  // se resuelven en la caché negativa sin consultar la tabla.
+  int userIndex = -1;
+  if (negativeCacheContains(cardId)) {
+    metrics.negativeCacheHits++;
+  } else {
+    userIndex = findUserByCardId(cardId);
+    if (userIndex < 0) negativeCacheAdd(cardId);
+  }
+  
+  // Sin usuario: consultar la lista blanca de rangos (un byte de flash)
+  int rangeIndex = (userIndex < 0) ? cardRangeAllows(cardId) : -1;
+  bool known = (userIndex >= 0 || rangeIndex >= 0);
+  uint8_t recordId[5];
+  uint8_t group = 0;
+  const char* name = "";
+  if (userIndex >= 0) {
+    memcpy(recordId, users[userIndex].id, 5);
+    group = users[userIndex].group;
+    name = (char*)users[userIndex].name;
+  } else if (rangeIndex >= 0) {
+    cardRangeRecordId(cardId, recordId);
+    group = cardRanges[rangeIndex].group;
+    name = cardRanges[rangeIndex].label;
+  }
+  
+  // Barrido con tarjetas desconocidas: agotado el cupo del lector, el
+  // intento solo queda anotado (sin LED, evento ni búsqueda)
+  if (!known && !readerRateAllows(reader)) {
+    metrics.accessThrottled++;
+    logDenial(cardId, DENY_THROTTLED, reader);
+    return;
+  }
+  
+  // Comprobar el horario de su grupo (una comprobación de bit, ver horarios.h)
+  bool inSchedule = known && scheduleAllows(group, now() - 946684800);
+  
+  // Anti-passback: no repetir el mismo sentido dentro del plazo configurado
+  bool passback = inSchedule && antiPassbackViolation(cardId, direction);
+  
+  if (known && inSchedule && !passback) {
+    // Usuario o tarjeta de rango encontrados
+    Serial.print("[WIEGAND] Acceso concedido a: ");
+    Serial.println(name);
     
-    // Buscar usuario por tarjeta
-    int userIndex = findUserByCardId(cardId);
+    // Iniciar estado de acceso concedido
+    currentLedState = LED_ACCESS_GRANTED;
+    actionStartTime = millis();
+    digitalWrite(basicConfig.pin_relay, HIGH);
+    digitalWrite(basicConfig.pin_led, HIGH);
     
-    if (userIndex >= 0) {
-      // Usuario encontrado
-      if (currentLedState == LED_IDLE) { // Procesar solo si no hay otra acción en curso
-        Serial.print("[WIEGAND] Acceso concedido a: ");
-        Serial.println((char*)users[userIndex].name);
-        
-        // Iniciar estado de acceso concedido
-        currentLedState = LED_ACCESS_GRANTED;
-        actionStartTime = millis();
-        digitalWrite(basicConfig.pin_relay, HIGH);
-        digitalWrite(basicConfig.pin_led, HIGH);
-        
-        // Crear registro de acceso
-        createAccessRecord(userIndex);
-      }
+    // Crear registro de acceso
+    createAccessRecord(recordId, cardId, direction);
+    noteGrantedSwipe(cardId, direction);
+    metrics.accessGranted++;
+  } else {
+    // Usuario no encontrado, fuera de horario o anti-passback
+    logDenial(cardId, passback ? DENY_PASSBACK : (known ? DENY_SCHEDULE : DENY_UNKNOWN), reader);
+    if (passback) {
+      Serial.print("[WIEGAND] Anti-passback: ");
+      Serial.println(name);
+    } else if (known) {
+      Serial.print("[WIEGAND] Fuera de horario: ");
+      Serial.println(name);
     } else {
-      // Usuario no encontrado
-      if (currentLedState == LED_IDLE) { // Procesar solo si no hay otra acción en curso
-        Serial.println("[WIEGAND] Tarjeta no autorizada");
-        
-        // Iniciar estado de acceso denegado
-        currentLedState = LED_ACCESS_DENIED;
-        actionStartTime = millis();
-        ledBlinkTime = millis();
-        blinkCount = 0;
-      }
+      Serial.println("[WIEGAND] Tarjeta no autorizada");
     }
     
-    // Resetear variables Wiegand para la próxima lectura
-    wiegandData = 0;
-    wiegandBitCount = 0;
+    // Iniciar estado de acceso denegado
+    currentLedState = LED_ACCESS_DENIED;
+    actionStartTime = millis();
+    ledBlinkTime = millis();
+    blinkCount = 0;
+
+    metrics.accessDenied++;
+
+    // Notificar a los suscriptores en vivo
+    AccessEvent event = {0};
+    event.timestamp = now() - 946684800;
+    event.cardId = cardId;
+    event.kind = EVENT_DENIED;
+    event.recordType = direction;
+    if (known) {
+      memcpy(event.id, recordId, 5);
+      event.kind = passback ? EVENT_DENIED_PASSBACK : EVENT_DENIED_SCHEDULE;
+    }
+    emitAccessEvent(event);
   }
 }
 
@@ -403,27 +551,35 @@ void handleLedAndRelay() {
 }
 
 // ========= FUNCIÓN PARA CREAR REGISTROS DE ACCESO ===========
-void createAccessRecord(int userIndex) {
-  // Usar recordCount como índice de escritura en un búfer circular
-  int writeIndex = recordCount % 500;
-
-  AccessRecord& record = records[writeIndex]; // Obtener referencia al registro
-
-  memcpy(record.id, users[userIndex].id, 5);
+// id: ID de usuario, o la tarjeta si el acceso es por rango (ver rangos.h)
+// recordType: 0x80 | sentido del lector
+void createAccessRecord(const uint8_t* id, uint32_t cardId, uint8_t recordType) {
+  AccessRecord record;
+  memcpy(record.id, id, 5);
   
   // Calcular timestamp (segundos desde 2000-01-01)
-  record.timestamp = now() - 946684800; // Unix timestamp - timestamp 2000-01-01
+  setRecordTime(record, now() - 946684800); // Unix timestamp - timestamp 2000-01-01
   
   record.backup = 0x08; // Indicar acceso por tarjeta
-  record.recordType = 0x80; // Indicar acceso exitoso (bit 7 = 1)
+  record.recordType = recordType; // Acceso exitoso (bit 7 = 1) y sentido
   memset(record.workCode, 0, 3); // Sin código de trabajo
   
-  recordCount++;
-  newRecordCount++;
+  // Añadir al búfer circular e índice temporal (registros.h)
+  uint32_t seq = appendRecord(record);
+  
+  // Notificar a los suscriptores en vivo
+  AccessEvent event = {0};
+  event.seq = seq;
+  event.timestamp = recordTime(record);
+  event.cardId = cardId;
+  memcpy(event.id, record.id, 5);
+  event.kind = EVENT_GRANTED;
+  event.recordType = record.recordType;
+  emitAccessEvent(event);
 
   // Opcional: Guardar inmediatamente si el búfer se llena, 
   // aunque el guardado periódico en el loop es más eficiente.
-  if (recordCount % 500 == 0) {
+  if (recordCount % MAX_RECORDS == 0) {
     saveRecords();
   }
 }
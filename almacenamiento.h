@@ -14,7 +14,7 @@ void loadConfig() {
     return;
   }
   
-  DynamicJsonDocument doc(512);
+  DynamicJsonDocument doc(1024);
   DeserializationError error = deserializeJson(doc, file);
   if (error) {
     Serial.println("Error al leer configuración");
@@ -39,9 +39,23 @@ void loadConfig() {
   basicConfig.languageFlag = doc["langflag"] | 0x10;
   basicConfig.cmdVersion = doc["cmdver"] | 0x02;
 
-  // Cargar pines GPIO, con valores por defecto si no existen
-  basicConfig.pin_d0 = doc["pin_d0"] | D7;
-  basicConfig.pin_d1 = doc["pin_d1"] | D6;
+  // Cargar pines GPIO, con valores por defecto si no existen. Las
+  // configuraciones de un solo lector guardan sus pines en pin_d0/pin_d1.
+  JsonArray readers = doc["readers"];
+  if (readers.size() > 0) {
+    basicConfig.readerCount = 0;
+    for (int i = 0; i < readers.size() && i < MAX_READERS; i++) {
+      ReaderConfig& reader = basicConfig.readers[basicConfig.readerCount++];
+      reader.pin_d0 = readers[i][0] | D7;
+      reader.pin_d1 = readers[i][1] | D6;
+      reader.direction = readers[i][2] | 0;
+    }
+  } else {
+    basicConfig.readers[0].pin_d0 = doc["pin_d0"] | D7;
+    basicConfig.readers[0].pin_d1 = doc["pin_d1"] | D6;
+    basicConfig.readers[0].direction = 0;
+    basicConfig.readerCount = 1;
+  }
   basicConfig.pin_relay = doc["pin_relay"] | D1;
   basicConfig.pin_led = doc["pin_led"] | D0;
 
@@ -49,12 +63,24 @@ void loadConfig() {
   basicConfig.rebootEnabled = doc["rebootEnabled"] | false;
   basicConfig.rebootHour = doc["rebootHour"] | 3; // 3 AM por defecto
   basicConfig.rebootMinute = doc["rebootMinute"] | 0;
+
+  // Control de lecturas repetidas y anti-passback
+  basicConfig.duplicateWindow = doc["dupWindow"] | 3000;
+  basicConfig.antiPassbackTime = doc["antiPassback"] | 0;
+
+  // Sesión TCP con CrossChex
+  basicConfig.sessionIdleTimeout = doc["idleTimeout"] | 300;
+  basicConfig.keepAliveIdle = doc["keepAlive"] | 30;
+  basicConfig.bulkPages = doc["bulkPages"] | 1;
+  if (basicConfig.bulkPages < 1) basicConfig.bulkPages = 1;
+  if (basicConfig.bulkPages > BULK_MAX_PAGES) basicConfig.bulkPages = BULK_MAX_PAGES;
   
   file.close();
 }
 
 void saveConfig() {
-  DynamicJsonDocument doc(512);
+  MemProfileScope memScope(MEM_OP_SAVE);
+  DynamicJsonDocument doc(1024);
 
   doc["deviceId"] = deviceId;
   
@@ -74,8 +100,13 @@ void saveConfig() {
   doc["cmdver"] = basicConfig.cmdVersion;
 
   // Guardar pines GPIO
-  doc["pin_d0"] = basicConfig.pin_d0;
-  doc["pin_d1"] = basicConfig.pin_d1;
+  JsonArray readers = doc.createNestedArray("readers");
+  for (int i = 0; i < basicConfig.readerCount; i++) {
+    JsonArray reader = readers.createNestedArray();
+    reader.add(basicConfig.readers[i].pin_d0);
+    reader.add(basicConfig.readers[i].pin_d1);
+    reader.add(basicConfig.readers[i].direction);
+  }
   doc["pin_relay"] = basicConfig.pin_relay;
   doc["pin_led"] = basicConfig.pin_led;
 
@@ -83,6 +114,15 @@ void saveConfig() {
   doc["rebootEnabled"] = basicConfig.rebootEnabled;
   doc["rebootHour"] = basicConfig.rebootHour;
   doc["rebootMinute"] = basicConfig.rebootMinute;
+
+  // Guardar control de lecturas repetidas y anti-passback
+  doc["dupWindow"] = basicConfig.duplicateWindow;
+  doc["antiPassback"] = basicConfig.antiPassbackTime;
+
+  // Guardar sesión TCP con CrossChex
+  doc["idleTimeout"] = basicConfig.sessionIdleTimeout;
+  doc["keepAlive"] = basicConfig.keepAliveIdle;
+  doc["bulkPages"] = basicConfig.bulkPages;
   
   File file = SPIFFS.open("/config.json", "w");
   if (!file) {
@@ -130,6 +170,182 @@ void saveWebAuth() {
   file.close();
 }
 
+// Reglas de horario y festivos. Tras cargar se compilan a mapas de bits.
+void loadSchedules() {
+  File file = SPIFFS.open("/schedule.json", "r");
+  if (!file) {
+    Serial.println("No hay archivo de horarios, acceso sin restriccion horaria.");
+    compileSchedules();
+    return;
+  }
+
+  DynamicJsonDocument doc(4096);
+  DeserializationError error = deserializeJson(doc, file);
+  file.close();
+  if (error) {
+    Serial.println("Error al leer horarios.");
+    compileSchedules();
+    return;
+  }
+
+  JsonArray rules = doc["rules"];
+  scheduleRuleCount = 0;
+  for (int i = 0; i < rules.size() && scheduleRuleCount < MAX_SCHEDULE_RULES; i++) {
+    ScheduleRule& rule = scheduleRules[scheduleRuleCount++];
+    rule.group = rules[i]["g"] | 0;
+    rule.days = rules[i]["d"] | 0;
+    rule.startSlot = rules[i]["s"] | 0;
+    rule.endSlot = rules[i]["e"] | 0;
+  }
+
+  JsonArray days = doc["holidays"];
+  holidayCount = 0;
+  for (int i = 0; i < days.size() && holidayCount < MAX_HOLIDAYS; i++) {
+    holidays[holidayCount++] = days[i] | 0;
+  }
+
+  compileSchedules();
+}
+
+void saveSchedules() {
+  DynamicJsonDocument doc(4096);
+  JsonArray rules = doc.createNestedArray("rules");
+  for (int i = 0; i < scheduleRuleCount; i++) {
+    JsonObject obj = rules.createNestedObject();
+    obj["g"] = scheduleRules[i].group;
+    obj["d"] = scheduleRules[i].days;
+    obj["s"] = scheduleRules[i].startSlot;
+    obj["e"] = scheduleRules[i].endSlot;
+  }
+  JsonArray days = doc.createNestedArray("holidays");
+  for (int i = 0; i < holidayCount; i++) {
+    days.add(holidays[i]);
+  }
+
+  File file = SPIFFS.open("/schedule.json", "w");
+  if (!file) {
+    Serial.println("Error al crear archivo de horarios.");
+    return;
+  }
+
+  serializeJson(doc, file);
+  file.close();
+}
+
+// Cabeceras de los rangos de tarjetas. Los mapas de bits ya están en sus
+// propios archivos y se actualizan en su sitio (ver rangos.h).
+void loadCardRanges() {
+  File file = SPIFFS.open("/ranges.json", "r");
+  if (!file) {
+    return;
+  }
+
+  DynamicJsonDocument doc(2048);
+  DeserializationError error = deserializeJson(doc, file);
+  file.close();
+  if (error) {
+    Serial.println("Error al leer rangos de tarjetas.");
+    return;
+  }
+
+  JsonArray ranges = doc["ranges"];
+  cardRangeCount = 0;
+  for (int i = 0; i < ranges.size() && cardRangeCount < MAX_CARD_RANGES; i++) {
+    CardRange& range = cardRanges[cardRangeCount++];
+    range.firstCard = ranges[i]["first"] | 0;
+    range.count = ranges[i]["count"] | 0;
+    range.enabled = ranges[i]["enabled"] | 0;
+    range.group = ranges[i]["group"] | 0;
+    range.file = ranges[i]["file"] | 0;
+    strlcpy(range.label, ranges[i]["label"] | "", sizeof(range.label));
+  }
+}
+
+void saveCardRanges() {
+  DynamicJsonDocument doc(2048);
+  JsonArray ranges = doc.createNestedArray("ranges");
+  for (int i = 0; i < cardRangeCount; i++) {
+    JsonObject obj = ranges.createNestedObject();
+    obj["first"] = cardRanges[i].firstCard;
+    obj["count"] = cardRanges[i].count;
+    obj["enabled"] = cardRanges[i].enabled;
+    obj["group"] = cardRanges[i].group;
+    obj["file"] = cardRanges[i].file;
+    obj["label"] = cardRanges[i].label;
+  }
+
+  File file = SPIFFS.open("/ranges.json", "w");
+  if (!file) {
+    Serial.println("Error al crear archivo de rangos de tarjetas.");
+    return;
+  }
+
+  serializeJson(doc, file);
+  file.close();
+}
+
+// ========= DIARIO DE CAMBIOS DE USUARIOS ===========
+// Se guarda junto a users.json: cabecera y el anillo tal cual está en memoria
+#define USER_JOURNAL_MAGIC 0x314E4A55UL  // "UJN1"
+
+typedef struct {
+  uint32_t magic;
+  uint32_t count;       // userJournalCount
+  uint32_t version;     // userVersion
+  uint32_t base;        // userJournalBase
+} UserJournalHeader;
+
+// Cada cambio anotado recibe la versión siguiente, así que el diario guarda
+// exactamente (version - base) cambios, tantos como anotados hasta llenar el
+// anillo. Una cabecera que no lo cumple está dañada y el diario se descarta.
+bool userJournalHeaderValid(const UserJournalHeader& header) {
+  if (header.magic != USER_JOURNAL_MAGIC || header.base > header.version) return false;
+  uint32_t stored = (header.count < USER_JOURNAL_SIZE) ? header.count : USER_JOURNAL_SIZE;
+  return header.version - header.base == stored;
+}
+
+void loadUserJournal() {
+  File file = SPIFFS.open("/user_journal.bin", "r");
+  UserJournalHeader header;
+  if (file && file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+      userJournalHeaderValid(header) &&
+      file.read((uint8_t*)userJournal, sizeof(userJournal)) == sizeof(userJournal)) {
+    userJournalCount = header.count;
+    userVersion = header.version;
+    userJournalBase = header.base;
+    file.close();
+    return;
+  }
+  if (file) {
+    if (file.size() > 0) Serial.println("Diario de usuarios dañado, se descarta");
+    file.close();
+  }
+
+  // Sin diario (primer arranque con esta versión): continuar desde la mayor
+  // versión guardada. Con usuarios anteriores al diario la versión parte de
+  // 1, así un cliente que empieza desde 0 recibe la orden de resincronizar.
+  userVersion = 0;
+  for (int i = 0; i < userCount; i++) {
+    if (users[i].version > userVersion) userVersion = users[i].version;
+  }
+  if (userCount > 0 && userVersion == 0) userVersion = 1;
+  userJournalBase = userVersion;
+  userJournalCount = 0;
+}
+
+void saveUserJournal() {
+  File file = SPIFFS.open("/user_journal.bin", "w");
+  if (!file) {
+    Serial.println("Error al crear archivo de diario de usuarios");
+    return;
+  }
+
+  UserJournalHeader header = { USER_JOURNAL_MAGIC, userJournalCount, userVersion, userJournalBase };
+  metrics.flashBytesUsers += file.write((const uint8_t*)&header, sizeof(header));
+  metrics.flashBytesUsers += file.write((const uint8_t*)userJournal, sizeof(userJournal));
+  file.close();
+}
+
 void loadUsers() {
   File file = SPIFFS.open("/users.json", "r");
   if (!file) {
@@ -147,7 +363,7 @@ void loadUsers() {
   userCount = doc["count"] | 0;
   JsonArray array = doc["users"];
   
-  for (int i = 0; i < userCount && i < 100 && i < array.size(); i++) {
+  for (int i = 0; i < userCount && i < MAX_USERS && i < array.size(); i++) {
     JsonArray id = array[i]["id"];
     for (int j = 0; j < 5 && j < id.size(); j++) {
       users[i].id[j] = id[j];
@@ -175,12 +391,16 @@ void loadUsers() {
     
     users[i].special = array[i]["special"] | 0;
     users[i].isActive = array[i]["active"] | true;
+    users[i].version = array[i]["ver"] | 0;
   }
+  invalidateUserIndex();
   
   file.close();
+  loadUserJournal();
 }
 
 void saveUsers() {
+  MemProfileScope memScope(MEM_OP_SAVE);
   DynamicJsonDocument doc(10000);
   doc["count"] = userCount;
   JsonArray array = doc.createNestedArray("users");
@@ -211,18 +431,254 @@ void saveUsers() {
     
     obj["special"] = users[i].special;
     obj["active"] = users[i].isActive;
+    obj["ver"] = users[i].version;
   }
   
+  memProfileSample(); // Pico de memoria: documento completo en el heap
+  
   File file = SPIFFS.open("/users.json", "w");
   if (!file) {
     Serial.println("Error al crear archivo de usuarios");
     return;
   }
   
+  metrics.flashBytesUsers += serializeJson(doc, file);
+  file.close();
+  saveUserJournal();
+}
+
+// ========= ASISTENCIA DIARIA ===========
+// Formato binario compacto: cabecera y la tabla tal cual está en memoria
+#define ATTENDANCE_FILE_MAGIC 0x41544431UL  // "ATD1"
+
+typedef struct {
+  uint32_t magic;
+  uint16_t count;
+  uint16_t entrySize;
+} AttendanceFileHeader;
+
+void loadAttendance() {
+  File file = SPIFFS.open("/attendance.bin", "r");
+  if (!file) {
+    // Primer arranque con esta versión: calcular desde los registros
+    Serial.println("No existe archivo de asistencia, recalculando");
+    rebuildAttendance();
+    return;
+  }
+
+  AttendanceFileHeader header;
+  if (file.read((uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+      header.magic != ATTENDANCE_FILE_MAGIC || header.entrySize != sizeof(DailyAttendance) ||
+      header.count > MAX_ATTENDANCE_ENTRIES) {
+    Serial.println("Archivo de asistencia no valido, recalculando");
+    file.close();
+    rebuildAttendance();
+    return;
+  }
+
+  size_t bytes = header.count * sizeof(DailyAttendance);
+  attendanceCount = (file.read((uint8_t*)attendance, bytes) == bytes) ? header.count : 0;
+  attendanceDirty = false;
+  file.close();
+}
+
+void saveAttendance() {
+  if (!attendanceDirty) return;
+
+  File file = SPIFFS.open("/attendance.bin", "w");
+  if (!file) {
+    Serial.println("Error al crear archivo de asistencia");
+    return;
+  }
+
+  AttendanceFileHeader header = { ATTENDANCE_FILE_MAGIC, (uint16_t)attendanceCount, sizeof(DailyAttendance) };
+  metrics.flashBytesAttendance += file.write((const uint8_t*)&header, sizeof(header));
+  metrics.flashBytesAttendance += file.write((const uint8_t*)attendance, attendanceCount * sizeof(DailyAttendance));
+  file.close();
+  attendanceDirty = false;
+}
+
+// ========= ENVÍO A COLECTOR ===========
+#define PUSH_CURSOR_MAGIC 0x31485350UL  // "PSH1"
+
+void loadPushConfig() {
+  File file = SPIFFS.open("/push.json", "r");
+  if (!file) {
+    // Valores por defecto: desactivado
+    pushConfig.port = 5010;
+    strcpy(pushConfig.path, "/");
+    pushConfig.batchSize = 10;
+    return;
+  }
+
+  DynamicJsonDocument doc(512);
+  DeserializationError error = deserializeJson(doc, file);
+  file.close();
+  if (error) {
+    Serial.println("Error al leer configuracion de envio.");
+    return;
+  }
+
+  pushConfig.enabled = doc["enabled"] | false;
+  pushConfig.mode = doc["mode"] | PUSH_TCP_ANVIZ;
+  strlcpy(pushConfig.host, doc["host"] | "", sizeof(pushConfig.host));
+  pushConfig.port = doc["port"] | 5010;
+  strlcpy(pushConfig.path, doc["path"] | "/", sizeof(pushConfig.path));
+  pushConfig.batchSize = doc["batch"] | 10;
+}
+
+void savePushConfig() {
+  DynamicJsonDocument doc(512);
+  doc["enabled"] = pushConfig.enabled;
+  doc["mode"] = pushConfig.mode;
+  doc["host"] = pushConfig.host;
+  doc["port"] = pushConfig.port;
+  doc["path"] = pushConfig.path;
+  doc["batch"] = pushConfig.batchSize;
+
+  File file = SPIFFS.open("/push.json", "w");
+  if (!file) {
+    Serial.println("Error al crear archivo de configuracion de envio.");
+    return;
+  }
+
+  serializeJson(doc, file);
+  file.close();
+}
+
+// Cursor del envío: secuencia del primer registro sin confirmar. Se escribe
+// como mucho cada PUSH_CURSOR_SAVE_INTERVAL; tras un reinicio se reenvían los
+// registros confirmados desde la última escritura (el colector descarta
+// duplicados por su secuencia).
+void loadPushCursor() {
+  File file = SPIFFS.open("/push_cursor.bin", "r");
+  if (!file) {
+    // Sin cursor guardado: empezar por los registros que aún no ha visto nadie
+    pushCursor = recordCount;
+    return;
+  }
+
+  uint32_t data[2];
+  if (file.read((uint8_t*)data, sizeof(data)) == sizeof(data) && data[0] == PUSH_CURSOR_MAGIC) {
+    pushCursor = data[1];
+  } else {
+    pushCursor = recordCount;
+  }
+  file.close();
+}
+
+void savePushCursor() {
+  File file = SPIFFS.open("/push_cursor.bin", "w");
+  if (!file) {
+    Serial.println("Error al crear archivo de cursor de envio");
+    return;
+  }
+
+  uint32_t data[2] = { PUSH_CURSOR_MAGIC, pushCursor };
+  file.write((const uint8_t*)data, sizeof(data));
+  file.close();
+  pushCursorDirty = false;
+  pushCursorSavedAt = millis();
+}
+
+// ========= CURSORES DE DESCARGA ===========
+// Cabecera y la tabla de cursores tal cual está en memoria. Se escribe como
+// mucho cada DOWNLOAD_CURSOR_SAVE_INTERVAL; tras un reinicio se reenvían los
+// registros confirmados desde la última escritura.
+#define DOWNLOAD_CURSOR_MAGIC 0x31434C44UL  // "DLC1"
+
+typedef struct {
+  uint32_t magic;
+  uint32_t clock;       // downloadCursorClock
+} DownloadCursorHeader;
+
+void loadDownloadCursors() {
+  File file = SPIFFS.open("/download_cursors.bin", "r");
+  if (!file) return;
+
+  DownloadCursorHeader header;
+  if (file.read((uint8_t*)&header, sizeof(header)) != sizeof(header) || header.magic != DOWNLOAD_CURSOR_MAGIC ||
+      file.read((uint8_t*)downloadCursors, sizeof(downloadCursors)) != sizeof(downloadCursors)) {
+    memset(downloadCursors, 0, sizeof(downloadCursors));
+    file.close();
+    return;
+  }
+  file.close();
+  downloadCursorClock = header.clock;
+
+  // Los lotes en vuelo al reiniciar no se confirmaron. newRecordCount se
+  // guarda con los registros y puede ser anterior a la última confirmación.
+  for (int i = 0; i < MAX_DOWNLOAD_CLIENTS; i++) {
+    DownloadCursor& cursor = downloadCursors[i];
+    if (cursor.ip == 0) continue;
+    cursor.sent = cursor.acked;
+    if (cursor.acked <= (uint32_t)recordCount && newRecordCount > (int)(recordCount - cursor.acked)) {
+      newRecordCount = recordCount - cursor.acked;
+    }
+  }
+}
+
+void saveDownloadCursors() {
+  File file = SPIFFS.open("/download_cursors.bin", "w");
+  if (!file) {
+    Serial.println("Error al crear archivo de cursores de descarga");
+    return;
+  }
+
+  DownloadCursorHeader header = { DOWNLOAD_CURSOR_MAGIC, downloadCursorClock };
+  file.write((const uint8_t*)&header, sizeof(header));
+  file.write((const uint8_t*)downloadCursors, sizeof(downloadCursors));
+  file.close();
+  downloadCursorsDirty = false;
+  downloadCursorsSavedAt = millis();
+}
+
+// ========= MQTT ===========
+void loadMqttConfig() {
+  File file = SPIFFS.open("/mqtt.json", "r");
+  if (!file) {
+    // Valores por defecto: desactivado
+    mqttConfig.port = 1883;
+    strcpy(mqttConfig.prefix, "anviz");
+    return;
+  }
+
+  DynamicJsonDocument doc(512);
+  DeserializationError error = deserializeJson(doc, file);
+  file.close();
+  if (error) {
+    Serial.println("Error al leer configuracion MQTT.");
+    return;
+  }
+
+  mqttConfig.enabled = doc["enabled"] | false;
+  strlcpy(mqttConfig.host, doc["host"] | "", sizeof(mqttConfig.host));
+  mqttConfig.port = doc["port"] | 1883;
+  strlcpy(mqttConfig.user, doc["user"] | "", sizeof(mqttConfig.user));
+  strlcpy(mqttConfig.pass, doc["pass"] | "", sizeof(mqttConfig.pass));
+  strlcpy(mqttConfig.prefix, doc["prefix"] | "anviz", sizeof(mqttConfig.prefix));
+}
+
+void saveMqttConfig() {
+  DynamicJsonDocument doc(512);
+  doc["enabled"] = mqttConfig.enabled;
+  doc["host"] = mqttConfig.host;
+  doc["port"] = mqttConfig.port;
+  doc["user"] = mqttConfig.user;
+  doc["pass"] = mqttConfig.pass;
+  doc["prefix"] = mqttConfig.prefix;
+
+  File file = SPIFFS.open("/mqtt.json", "w");
+  if (!file) {
+    Serial.println("Error al crear archivo de configuracion MQTT.");
+    return;
+  }
+
   serializeJson(doc, file);
   file.close();
 }
 
+// ========= REGISTROS DE ACCESO ===========
 void loadRecords() {
   File file = SPIFFS.open("/records.json", "r");
   if (!file) {
@@ -239,59 +695,77 @@ void loadRecords() {
   
   recordCount = doc["count"] | 0;
   newRecordCount = doc["new"] | 0;
+  recordBase = doc["base"] | 0;
   JsonArray array = doc["records"];
   
-  for (int i = 0; i < recordCount && i < 500 && i < array.size(); i++) {
+  // Los registros se guardan por orden de secuencia desde firstRecordSeq().
+  // Los archivos sin "base" (anteriores) guardan las posiciones físicas del
+  // búfer, que coinciden porque entonces la secuencia empezaba en 0.
+  bool physical = doc["base"].isNull();
+  uint32_t first = firstRecordSeq();
+  for (int i = 0; i < storedRecordCount() && i < array.size(); i++) {
+    AccessRecord& record = physical ? records[i] : recordBySeq(first + i);
     JsonArray id = array[i]["id"];
     for (int j = 0; j < 5 && j < id.size(); j++) {
-      records[i].id[j] = id[j];
+      record.id[j] = id[j];
     }
     
-    records[i].timestamp = array[i]["time"] | 0;
-    records[i].backup = array[i]["backup"] | 0;
-    records[i].recordType = array[i]["type"] | 0;
+    setRecordTime(record, array[i]["time"] | 0);
+    record.backup = array[i]["backup"] | 0;
+    record.recordType = array[i]["type"] | 0;
     
     JsonArray work = array[i]["work"];
     for (int j = 0; j < 3 && j < work.size(); j++) {
-      records[i].workCode[j] = work[j];
+      record.workCode[j] = work[j];
     }
   }
   
   file.close();
+  rebuildRecordIndex();
 }
 
 void saveRecords() {
+  MemProfileScope memScope(MEM_OP_SAVE);
   DynamicJsonDocument doc(20000);
   doc["count"] = recordCount;
   doc["new"] = newRecordCount;
+  doc["base"] = recordBase;
   JsonArray array = doc.createNestedArray("records");
   
-  for (int i = 0; i < recordCount; i++) {
+  // Solo los registros almacenados, por orden de secuencia
+  uint32_t first = firstRecordSeq();
+  for (int i = 0; i < storedRecordCount(); i++) {
+    const AccessRecord& record = recordBySeq(first + i);
     JsonObject obj = array.createNestedObject();
     
     JsonArray id = obj.createNestedArray("id");
     for (int j = 0; j < 5; j++) {
-      id.add(records[i].id[j]);
+      id.add(record.id[j]);
     }
     
-    obj["time"] = records[i].timestamp;
-    obj["backup"] = records[i].backup;
-    obj["type"] = records[i].recordType;
+    obj["time"] = recordTime(record);
+    obj["backup"] = record.backup;
+    obj["type"] = record.recordType;
     
     JsonArray work = obj.createNestedArray("work");
     for (int j = 0; j < 3; j++) {
-      work.add(records[i].workCode[j]);
+      work.add(record.workCode[j]);
     }
   }
   
+  memProfileSample(); // Pico de memoria: documento completo en el heap
+  
   File file = SPIFFS.open("/records.json", "w");
   if (!file) {
     Serial.println("Error al crear archivo de registros");
     return;
   }
   
-  serializeJson(doc, file);
+  metrics.flashBytesRecords += serializeJson(doc, file);
   file.close();
+
+  // Los resúmenes de asistencia se guardan junto con los registros
+  saveAttendance();
 }
 
 #endif // ALMACENAMIENTO_H
\ No newline at end of file
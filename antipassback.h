@@ -0,0 +1,100 @@
+/**
+ * antipassback.h
+ * Lecturas recientes por tarjeta: descarte de lecturas repetidas (tabla
+ * LRU de tamaño fijo) y anti-passback (tabla aparte de accesos concedidos)
+ */
+
+#ifndef ANTIPASSBACK_H
+#define ANTIPASSBACK_H
+
+#define SWIPE_CACHE_SIZE 16   // Tarjetas recordadas (se sustituye la menos reciente)
+#define PASSBACK_TABLE_SIZE 64 // Accesos concedidos recordados para el anti-passback
+
+SwipeEntry recentSwipes[SWIPE_CACHE_SIZE];
+
+// El anti-passback usa su propia tabla, en la que solo entran accesos
+// concedidos: las lecturas de tarjetas desconocidas o denegadas no pueden
+// desplazar a quien acaba de pasar.
+PassbackEntry passbackEntries[PASSBACK_TABLE_SIZE];
+
+// Buscar una tarjeta en la tabla. Devuelve nullptr si no está.
+SwipeEntry* findRecentSwipe(uint32_t cardId) {
+  for (int i = 0; i < SWIPE_CACHE_SIZE; i++) {
+    if (recentSwipes[i].used && recentSwipes[i].cardId == cardId) {
+      return &recentSwipes[i];
+    }
+  }
+  return nullptr;
+}
+
+// Obtener la entrada de una tarjeta, sustituyendo la menos reciente si no está
+SwipeEntry& touchRecentSwipe(uint32_t cardId) {
+  SwipeEntry* entry = findRecentSwipe(cardId);
+  if (entry != nullptr) return *entry;
+
+  int victim = 0;
+  for (int i = 0; i < SWIPE_CACHE_SIZE; i++) {
+    if (!recentSwipes[i].used) {
+      victim = i;
+      break;
+    }
+    if (recentSwipes[i].lastSeen < recentSwipes[victim].lastSeen) victim = i;
+  }
+  SwipeEntry& slot = recentSwipes[victim];
+  slot.cardId = cardId;
+  slot.used = true;
+  return slot;
+}
+
+// ¿Es una repetición de la misma tarjeta dentro de la ventana configurada?
+// Se comprueba antes de buscar el usuario: una tarjeta apoyada en el lector
+// no genera registros, eventos ni escrituras en flash. Mientras se siga
+// leyendo, la ventana se prolonga.
+bool suppressDuplicateSwipe(uint32_t cardId) {
+  uint32_t nowMs = millis();
+  SwipeEntry* entry = findRecentSwipe(cardId);
+  bool duplicate = entry != nullptr && basicConfig.duplicateWindow > 0 &&
+                   nowMs - entry->lastSeen < basicConfig.duplicateWindow;
+  touchRecentSwipe(cardId).lastSeen = nowMs;
+  return duplicate;
+}
+
+// Anti-passback: ¿ya pasó esta tarjeta en el mismo sentido hace menos del
+// tiempo configurado? (sin salida intermedia)
+bool antiPassbackViolation(uint32_t cardId, uint8_t direction) {
+  if (basicConfig.antiPassbackTime == 0) return false;
+  for (int i = 0; i < PASSBACK_TABLE_SIZE; i++) {
+    const PassbackEntry& entry = passbackEntries[i];
+    if (entry.used && entry.cardId == cardId) {
+      return entry.direction == direction &&
+             millis() - entry.lastGrant < (uint32_t)basicConfig.antiPassbackTime * 1000UL;
+    }
+  }
+  return false;
+}
+
+// Anotar un acceso concedido. Ocupa la entrada de la misma tarjeta, un hueco
+// libre o la del acceso concedido más antiguo: solo se pierde el
+// anti-passback de una tarjeta tras PASSBACK_TABLE_SIZE accesos de otras.
+void noteGrantedSwipe(uint32_t cardId, uint8_t direction) {
+  int slot = -1;
+  int oldest = 0;
+  for (int i = 0; i < PASSBACK_TABLE_SIZE; i++) {
+    if (passbackEntries[i].used && passbackEntries[i].cardId == cardId) {
+      slot = i;
+      break;
+    }
+    if (!passbackEntries[oldest].used) continue;
+    if (!passbackEntries[i].used ||
+        (int32_t)(passbackEntries[i].lastGrant - passbackEntries[oldest].lastGrant) < 0) {
+      oldest = i;
+    }
+  }
+  PassbackEntry& entry = passbackEntries[slot >= 0 ? slot : oldest];
+  entry.cardId = cardId;
+  entry.lastGrant = millis();
+  entry.direction = direction;
+  entry.used = true;
+}
+
+#endif // ANTIPASSBACK_H
@@ -0,0 +1,470 @@
+/**
+ * api.h
+ * API REST en JSON (paginada por cursor) para usuarios y registros
+ */
+
+#ifndef API_H
+#define API_H
+
+#define API_DEFAULT_LIMIT 100   // Elementos por página si no se indica "limit"
+#define API_MAX_LIMIT 1000      // Límite superior de "limit"
+
+// ========= FUNCIONES AUXILIARES ===========
+
+// Leer un parámetro numérico de la URL con valor por defecto
+long apiArgLong(const char* name, long defaultValue) {
+  if (!webServer.hasArg(name) || webServer.arg(name).length() == 0) {
+    return defaultValue;
+  }
+  return webServer.arg(name).toInt();
+}
+
+// Leer el parámetro "limit" acotado a [1, API_MAX_LIMIT]
+int apiLimit() {
+  long limit = apiArgLong("limit", API_DEFAULT_LIMIT);
+  if (limit < 1) limit = 1;
+  if (limit > API_MAX_LIMIT) limit = API_MAX_LIMIT;
+  return (int)limit;
+}
+
+// Responder con un error JSON
+void apiSendError(int code, const char* message) {
+  char buffer[96];
+  snprintf_P(buffer, sizeof(buffer), PSTR("{\"error\":\"%s\"}"), message);
+  webServer.send(code, "application/json", buffer);
+}
+
+// Construir una consulta de registros a partir de los parámetros de la URL:
+// cursor (secuencia), rango de tiempo (Unix, inclusivo) y usuario.
+// Devuelve false si ya se respondió con un error.
+bool apiRecordQuery(RecordQuery& query) {
+  long cursorArg = apiArgLong("cursor", 0);
+  recordQueryInit(query, (cursorArg < 0) ? 0 : (uint32_t)cursorArg);
+
+  long fromArg = apiArgLong("from", 0);
+  long toArg = apiArgLong("to", 0);
+  if (fromArg > 946684800L) query.from = fromArg - 946684800L;
+  if (toArg > 946684800L) query.to = toArg - 946684800L;
+
+  if (webServer.hasArg("user") && webServer.arg("user").length() > 0) {
+    if (!parseUserId(webServer.arg("user").c_str(), query.userId)) {
+      apiSendError(400, "user invalido");
+      return false;
+    }
+    query.filterUser = true;
+  }
+  return true;
+}
+
+// ========= ENDPOINTS ===========
+// Las respuestas se generan por partes desde el loop (ver respuestas.h):
+// cada paso del generador emite un elemento, así que la memoria es la misma
+// sea cual sea el tamaño de página.
+
+// GET /api/status
+// Estado del sistema y perfil de memoria para la página principal
+void handleApiStatus() {
+  if (!isAuthenticated()) return;
+
+  memProfileSample();
+  FSInfo fsInfo;
+  SPIFFS.info(fsInfo);
+
+  responseBegin(200, "application/json");
+  responsePrintf(PSTR("{\"ip\":\"%s\",\"rssi\":%d,\"ssid\":\"%s\",\"heap\":%u,\"fsFree\":%u,\"fsTotal\":%u,"),
+                 WiFi.localIP().toString().c_str(), WiFi.RSSI(), WiFi.SSID().c_str(), ESP.getFreeHeap(),
+                 (unsigned)(fsInfo.totalBytes - fsInfo.usedBytes), (unsigned)fsInfo.totalBytes);
+  responsePrintf(PSTR("\"users\":%d,\"records\":%d,\"newRecords\":%d,\"firstSeq\":%u,\"nextSeq\":%u,\"time\":\"%s\",\"mem\":["),
+                 userCount, storedRecordCount(), newRecordCount, firstRecordSeq(), recordCount, getFormattedDateTime().c_str());
+
+  bool first = true;
+  for (int i = 0; i < MEM_OP_COUNT; i++) {
+    const MemProfile& p = memProfiles[i];
+    if (p.samples == 0) continue;
+    responsePrintf(PSTR("%s{\"op\":\"%s\",\"heap\":%u,\"block\":%u,\"frag\":%u,\"stack\":%u,\"samples\":%u}"),
+                   first ? "" : ",", memOperationName((MemOperation)i), p.minFreeHeap, p.minMaxBlock,
+                   p.maxFragmentation, p.minFreeStack, p.samples);
+    first = false;
+  }
+  responseWrite_P(PSTR("]}"));
+  responseEnd();
+}
+
+// GET /api/users?cursor=ID&limit=L
+// Usuarios en orden de ID. "next" es el ID del último usuario devuelto (o
+// null al final) y la página siguiente empieza por el primer ID mayor, así
+// que las altas y bajas entre páginas no hacen saltar ni repetir a nadie.
+size_t streamApiUsers(HttpStream& s, char* out, size_t room) {
+  switch (s.phase) {
+    case 0:
+      s.phase = 1;
+      return clampPrinted(snprintf_P(out, room, PSTR("{\"users\":[")), room);
+
+    case 1: {
+      int pos = indexUserIdAfter(s.userIdSet ? s.userId : nullptr);
+      if (pos >= userCount || s.sent >= s.limit) {
+        s.phase = 2;
+        return 0;
+      }
+      const User& user = users[userIdOrder[pos]];
+      memcpy(s.userId, user.id, 5);
+      s.userIdSet = true;
+      char idText[16];
+      char nameText[64];
+      formatUserId(idText, sizeof(idText), user.id);
+      jsonEscapeName(nameText, sizeof(nameText), user.name);
+      return clampPrinted(snprintf_P(out, room,
+                                     PSTR("%s{\"id\":\"%s\",\"name\":\"%s\",\"card\":%u,\"dept\":%u,\"group\":%u,\"active\":%s,\"ver\":%u}"),
+                                     s.sent++ > 0 ? "," : "", idText, nameText, user.cardId,
+                                     user.department, user.group, user.isActive ? "true" : "false", user.version), room);
+    }
+
+    default:
+      s.done = true;
+      if (s.userIdSet && indexUserIdAfter(s.userId) < userCount) {
+        char nextText[16];
+        formatUserId(nextText, sizeof(nextText), s.userId);
+        return clampPrinted(snprintf_P(out, room, PSTR("],\"count\":%d,\"total\":%d,\"next\":\"%s\"}"), s.sent, userCount, nextText), room);
+      }
+      return clampPrinted(snprintf_P(out, room, PSTR("],\"count\":%d,\"total\":%d,\"next\":null}"), s.sent, userCount), room);
+  }
+}
+
+void handleApiUsers() {
+  if (!isAuthenticated()) return;
+
+  // Sin cursor se empieza por el primer ID
+  uint8_t cursorId[5];
+  bool hasCursor = webServer.hasArg("cursor") && webServer.arg("cursor").length() > 0;
+  if (hasCursor && !parseUserId(webServer.arg("cursor").c_str(), cursorId)) {
+    apiSendError(400, "cursor invalido");
+    return;
+  }
+  int limit = apiLimit();
+
+  HttpStream* s = beginHttpStream("application/json", streamApiUsers);
+  if (s == nullptr) return;
+  if (hasCursor) {
+    memcpy(s->userId, cursorId, 5);
+    s->userIdSet = true;
+  }
+  s->limit = limit;
+}
+
+// GET /api/users/changes?since=V&limit=L
+// Cambios de usuarios posteriores a la versión V, del más antiguo al más
+// reciente, con el estado actual del usuario ("user" es null en las bajas o
+// si el usuario ya no existe). Con "resync":true el diario ya no tiene todos
+// los cambios pedidos: hay que descargar /api/users completo y continuar
+// desde "version". "next" es la versión para la página siguiente o null.
+void handleApiUserChanges() {
+  if (!isAuthenticated()) return;
+
+  long sinceArg = apiArgLong("since", 0);
+  uint32_t since = (sinceArg < 0) ? 0 : (uint32_t)sinceArg;
+  int limit = apiLimit();
+
+  responseBegin(200, "application/json");
+  if (!userJournalCovers(since)) {
+    responsePrintf(PSTR("{\"version\":%u,\"resync\":true,\"changes\":[],\"next\":null}"), userVersion);
+    responseEnd();
+    return;
+  }
+
+  responsePrintf(PSTR("{\"version\":%u,\"resync\":false,\"changes\":["), userVersion);
+  int sent = 0;
+  uint32_t pos = userJournalFind(since);
+  for (; pos < userJournalCount && sent < limit; pos++) {
+    const UserChange& change = userJournal[pos % USER_JOURNAL_SIZE];
+    char idText[16];
+    formatUserId(idText, sizeof(idText), change.id);
+    responsePrintf(PSTR("%s{\"ver\":%u,\"op\":\"%s\",\"id\":\"%s\",\"user\":"),
+                   sent++ > 0 ? "," : "", change.version, userChangeOpName(change.op), idText);
+    int userIndex = (change.op == USER_CHANGE_DELETE) ? -1 : indexFindUserById(change.id);
+    if (userIndex < 0) {
+      responseWrite_P(PSTR("null}"));
+      continue;
+    }
+    const User& user = users[userIndex];
+    char nameText[64];
+    jsonEscapeName(nameText, sizeof(nameText), user.name);
+    responsePrintf(PSTR("{\"name\":\"%s\",\"card\":%u,\"dept\":%u,\"group\":%u,\"active\":%s}}"),
+                   nameText, user.cardId, user.department, user.group, user.isActive ? "true" : "false");
+  }
+  if (pos < userJournalCount) {
+    responsePrintf(PSTR("],\"next\":%u}"), userJournal[(pos - 1) % USER_JOURNAL_SIZE].version);
+  } else {
+    responseWrite_P(PSTR("],\"next\":null}"));
+  }
+  responseEnd();
+}
+
+// GET /api/records?cursor=SEQ&limit=L&from=UNIX&to=UNIX&user=ID
+// El cursor es el número de secuencia del registro (estable aunque lleguen
+// registros nuevos); "next" es el cursor de la página siguiente o null.
+size_t streamApiRecords(HttpStream& s, char* out, size_t room) {
+  switch (s.phase) {
+    case 0:
+      s.phase = 1;
+      return clampPrinted(snprintf_P(out, room, PSTR("{\"records\":[")), room);
+
+    case 1: {
+      uint32_t seq;
+      if (s.sent < s.limit && recordQueryNext(s.query, seq)) {
+        const AccessRecord& record = recordBySeq(seq);
+        char idText[16];
+        char timeText[24];
+        char nameText[64] = "";
+        formatUserId(idText, sizeof(idText), record.id);
+        formatTimestampTo(timeText, sizeof(timeText), recordTime(record));
+        int userIndex = indexFindUserById(record.id);
+        if (userIndex >= 0) {
+          jsonEscapeName(nameText, sizeof(nameText), users[userIndex].name);
+        }
+        return clampPrinted(snprintf_P(out, room,
+                                       PSTR("%s{\"seq\":%u,\"user\":\"%s\",\"name\":\"%s\",\"ts\":%u,\"time\":\"%s\",\"type\":%u,\"backup\":%u}"),
+                                       s.sent++ > 0 ? "," : "", seq, idText, nameText, recordTime(record) + 946684800UL, timeText,
+                                       record.recordType, record.backup), room);
+      }
+      s.phase = 2;
+      return 0;
+    }
+
+    default:
+      s.done = true;
+      if (s.query.cursor < s.query.end) {
+        return clampPrinted(snprintf_P(out, room, PSTR("],\"count\":%d,\"next\":%u}"), s.sent, s.query.cursor), room);
+      }
+      return clampPrinted(snprintf_P(out, room, PSTR("],\"count\":%d,\"next\":null}"), s.sent), room);
+  }
+}
+
+void handleApiRecords() {
+  if (!isAuthenticated()) return;
+
+  RecordQuery query;
+  if (!apiRecordQuery(query)) return;
+  int limit = apiLimit();
+  HttpStream* s = beginHttpStream("application/json", streamApiRecords);
+  if (s == nullptr) return;
+  s->query = query;
+  s->limit = limit;
+}
+
+// GET /export/records.csv?from=UNIX&to=UNIX&user=ID
+// Exporta los registros almacenados, del más antiguo al más reciente, con
+// los mismos filtros opcionales que /api/records.
+size_t streamRecordsCsv(HttpStream& s, char* out, size_t room) {
+  if (s.phase == 0) {
+    s.phase = 1;
+    return clampPrinted(snprintf_P(out, room, PSTR("seq,user_id,name,time,type,method\r\n")), room);
+  }
+  uint32_t seq;
+  if (!recordQueryNext(s.query, seq)) {
+    s.done = true;
+    return 0;
+  }
+
+  const AccessRecord& record = recordBySeq(seq);
+  char idText[16];
+  char timeText[24];
+  char nameText[24];
+  formatUserId(idText, sizeof(idText), record.id);
+  formatTimestampTo(timeText, sizeof(timeText), recordTime(record));
+
+  // Nombre resuelto por el índice de IDs; las comillas se duplican según CSV
+  nameText[0] = 0;
+  int userIndex = indexFindUserById(record.id);
+  if (userIndex >= 0) {
+    size_t pos = 0;
+    const char* name = users[userIndex].name;
+    for (int i = 0; i < 10 && name[i] && pos + 3 < sizeof(nameText); i++) {
+      if (name[i] == '"') nameText[pos++] = '"';
+      nameText[pos++] = name[i];
+    }
+    nameText[pos] = 0;
+  }
+
+  const char* method;
+  switch (record.backup) {
+    case 0x01: method = "password"; break;
+    case 0x02: method = "fingerprint"; break;
+    case 0x08: method = "card"; break;
+    default: method = "other"; break;
+  }
+
+  return clampPrinted(snprintf_P(out, room, PSTR("%u,%s,\"%s\",%s,%u,%s\r\n"),
+                                 seq, idText, nameText, timeText, record.recordType, method), room);
+}
+
+void handleExportRecordsCsv() {
+  if (!isAuthenticated()) return;
+
+  RecordQuery query;
+  if (!apiRecordQuery(query)) return;
+  HttpStream* s = beginHttpStream("text/csv; charset=UTF-8", streamRecordsCsv,
+                                  "Content-Disposition: attachment; filename=records.csv\r\n");
+  if (s == nullptr) return;
+  s->query = query;
+}
+
+// GET /api/attendance?date=YYYY-MM-DD (por defecto, hoy)
+// Recorre solo la tabla de resúmenes: O(usuarios), no O(registros)
+void handleApiAttendance() {
+  if (!isAuthenticated()) return;
+
+  uint16_t day = attendanceDay(now() - 946684800UL);
+  if (webServer.hasArg("date") && webServer.arg("date").length() > 0 &&
+      !parseDayText(webServer.arg("date").c_str(), day)) {
+    apiSendError(400, "date invalida");
+    return;
+  }
+
+  char dateText[12];
+  formatDayText(dateText, sizeof(dateText), day);
+
+  responseBegin(200, "application/json");
+  responsePrintf(PSTR("{\"date\":\"%s\",\"users\":["), dateText);
+  bool first = true;
+  for (int i = 0; i < attendanceCount; i++) {
+    const DailyAttendance& entry = attendance[i];
+    if (attendanceDay(entry.firstIn) != day) continue;
+
+    char idText[16];
+    char nameText[64] = "";
+    char firstText[24];
+    char lastText[24];
+    formatUserId(idText, sizeof(idText), entry.id);
+    int userIndex = indexFindUserById(entry.id);
+    if (userIndex >= 0) {
+      jsonEscapeName(nameText, sizeof(nameText), users[userIndex].name);
+    }
+    formatTimestampTo(firstText, sizeof(firstText), entry.firstIn);
+    formatTimestampTo(lastText, sizeof(lastText), entry.lastOut);
+    responsePrintf(PSTR("%s{\"id\":\"%s\",\"name\":\"%s\",\"firstIn\":\"%s\",\"lastOut\":\"%s\",\"count\":%u}"),
+                   first ? "" : ",", idText, nameText, &firstText[11], &lastText[11], entry.count);
+    first = false;
+  }
+  responseWrite_P(PSTR("]}"));
+  responseEnd();
+}
+
+// GET /api/denials
+// Registro de denegaciones en RAM, de la más reciente a la más antigua
+void handleApiDenials() {
+  if (!isAuthenticated()) return;
+
+  uint32_t stored = (denialLogCount < DENIAL_LOG_SIZE) ? denialLogCount : DENIAL_LOG_SIZE;
+  responseBegin(200, "application/json");
+  responsePrintf(PSTR("{\"total\":%u,\"throttled\":%u,\"denials\":["), denialLogCount, metrics.accessThrottled);
+  for (uint32_t i = 0; i < stored; i++) {
+    const DenialEntry& entry = denialLog[(denialLogCount - 1 - i) % DENIAL_LOG_SIZE];
+    char timeText[24];
+    formatTimestampTo(timeText, sizeof(timeText), entry.timestamp);
+    responsePrintf(PSTR("%s{\"ts\":%u,\"time\":\"%s\",\"card\":%u,\"reason\":\"%s\",\"reader\":%u,\"attempts\":%u}"),
+                   i > 0 ? "," : "", entry.timestamp + 946684800UL, timeText, entry.cardId,
+                   denyReasonName(entry.reason), entry.reader, entry.attempts);
+  }
+  responseWrite_P(PSTR("]}"));
+  responseEnd();
+}
+
+// GET /api/ranges
+// Rangos de tarjetas de la lista blanca con su número de tarjetas habilitadas
+void handleApiRanges() {
+  if (!isAuthenticated()) return;
+
+  responseBegin(200, "application/json");
+  responseWrite_P(PSTR("{\"ranges\":["));
+  for (int i = 0; i < cardRangeCount; i++) {
+    const CardRange& range = cardRanges[i];
+    char labelText[64];
+    jsonEscapeName(labelText, sizeof(labelText), range.label);
+    responsePrintf(PSTR("%s{\"first\":%u,\"last\":%u,\"count\":%u,\"enabled\":%u,\"group\":%u,\"label\":\"%s\"}"),
+                   i > 0 ? "," : "", range.firstCard, range.firstCard + range.count - 1, range.count,
+                   range.enabled, range.group, labelText);
+  }
+  responseWrite_P(PSTR("]}"));
+  responseEnd();
+}
+
+// Leer los parámetros first y last (inclusivo). Devuelve false si ya se respondió con un error.
+bool apiCardInterval(uint32_t& first, uint32_t& last) {
+  if (!webServer.hasArg("first") || !webServer.hasArg("last")) {
+    apiSendError(400, "faltan first y last");
+    return false;
+  }
+  first = strtoul(webServer.arg("first").c_str(), nullptr, 10);
+  last = strtoul(webServer.arg("last").c_str(), nullptr, 10);
+  if (last < first) {
+    apiSendError(400, "last menor que first");
+    return false;
+  }
+  return true;
+}
+
+// POST /api/ranges (first, last, group, label, enable=0|1)
+// Crea un rango; por defecto con todas sus tarjetas habilitadas
+void handleApiCreateRange() {
+  if (!isAuthenticated()) return;
+
+  uint32_t first, last;
+  if (!apiCardInterval(first, last)) return;
+  if (last - first >= MAX_RANGE_CARDS) {
+    apiSendError(400, "rango demasiado grande");
+    return;
+  }
+  long group = apiArgLong("group", 0);
+  if (group < 0 || group >= SCHEDULE_GROUPS) {
+    apiSendError(400, "group invalido");
+    return;
+  }
+
+  int index = createCardRange(first, last - first + 1, group, webServer.arg("label").c_str(), apiArgLong("enable", 1) != 0);
+  if (index < 0) {
+    apiSendError(409, "rango solapado, sin espacio o error de escritura");
+    return;
+  }
+  saveCardRanges();
+
+  char buffer[64];
+  snprintf_P(buffer, sizeof(buffer), PSTR("{\"enabled\":%u}"), cardRanges[index].enabled);
+  webServer.send(200, "application/json", buffer);
+}
+
+// POST /api/ranges/set (first, last, enable=0|1)
+// Habilita o deshabilita en bloque las tarjetas del intervalo en todos los
+// rangos que lo cortan
+void handleApiSetRange() {
+  if (!isAuthenticated()) return;
+
+  uint32_t first, last;
+  if (!apiCardInterval(first, last)) return;
+  bool enable = apiArgLong("enable", 1) != 0;
+
+  uint32_t changed = 0;
+  for (int i = 0; i < cardRangeCount; i++) {
+    changed += setCardRangeBits(i, first, last, enable);
+  }
+  if (changed > 0) saveCardRanges();
+
+  char buffer[64];
+  snprintf_P(buffer, sizeof(buffer), PSTR("{\"changed\":%u}"), changed);
+  webServer.send(200, "application/json", buffer);
+}
+
+// POST /api/ranges/delete (first): elimina el rango que contiene esa tarjeta
+void handleApiDeleteRange() {
+  if (!isAuthenticated()) return;
+
+  int index = findCardRange(strtoul(webServer.arg("first").c_str(), nullptr, 10));
+  if (index < 0) {
+    apiSendError(404, "rango no encontrado");
+    return;
+  }
+  deleteCardRange(index);
+  saveCardRanges();
+  webServer.send(200, "application/json", "{\"deleted\":true}");
+}
+
+#endif // API_H
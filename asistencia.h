@@ -0,0 +1,87 @@
+/**
+ * asistencia.h
+ * Resúmenes diarios de asistencia por usuario (primera entrada, última
+ * salida y número de registros), mantenidos al añadir cada registro
+ */
+
+#ifndef ASISTENCIA_H
+#define ASISTENCIA_H
+
+// Capacidad de la tabla: dos días completos con 100 usuarios, o más días si
+// no todos fichan. Al llenarse se descarta el resumen del día más antiguo.
+#define MAX_ATTENDANCE_ENTRIES 200
+
+DailyAttendance attendance[MAX_ATTENDANCE_ENTRIES];
+int attendanceCount = 0;
+bool attendanceDirty = false;   // Hay cambios sin guardar en flash
+
+// Declaración de funciones externas (definidas en rangos.h)
+extern bool isCardRangeRecordId(const uint8_t* id);
+
+// Día (desde 2000-01-01) al que pertenece un tiempo local
+uint16_t attendanceDay(uint32_t timestamp) {
+  return timestamp / 86400UL;
+}
+
+// Buscar el resumen de un usuario en un día. Devuelve la posición o -1.
+int findAttendance(const uint8_t* id, uint16_t day) {
+  for (int i = 0; i < attendanceCount; i++) {
+    if (attendanceDay(attendance[i].firstIn) == day && memcmp(attendance[i].id, id, 5) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Obtener una posición libre para un resumen del día indicado. Si la tabla
+// está llena se reutiliza la del día más antiguo, salvo que el nuevo día sea
+// aún más antiguo (registros viejos subidos por protocolo): entonces -1.
+int allocateAttendance(uint16_t day) {
+  if (attendanceCount < MAX_ATTENDANCE_ENTRIES) {
+    return attendanceCount++;
+  }
+  int oldest = 0;
+  for (int i = 1; i < attendanceCount; i++) {
+    if (attendance[i].firstIn < attendance[oldest].firstIn) oldest = i;
+  }
+  if (attendanceDay(attendance[oldest].firstIn) >= day) return -1;
+  return oldest;
+}
+
+// Incorporar un registro a los resúmenes. Los registros pueden llegar
+// desordenados (subidas 0x41), así que se mantienen mínimo y máximo.
+void updateAttendance(const AccessRecord& record) {
+  // Los accesos por rango (visitantes, contratas) no son empleados y no
+  // deben ocupar la tabla
+  if (isCardRangeRecordId(record.id)) return;
+  uint32_t timestamp = recordTime(record);
+  uint16_t day = attendanceDay(timestamp);
+  int i = findAttendance(record.id, day);
+  if (i < 0) {
+    i = allocateAttendance(day);
+    if (i < 0) return;
+    DailyAttendance& entry = attendance[i];
+    memcpy(entry.id, record.id, 5);
+    entry.reserved = 0;
+    entry.firstIn = timestamp;
+    entry.lastOut = timestamp;
+    entry.count = 0;
+  }
+
+  DailyAttendance& entry = attendance[i];
+  if (timestamp < entry.firstIn) entry.firstIn = timestamp;
+  if (timestamp > entry.lastOut) entry.lastOut = timestamp;
+  if (entry.count < UINT16_MAX) entry.count++;
+  attendanceDirty = true;
+}
+
+// Recalcular los resúmenes a partir de los registros almacenados (primer
+// arranque sin fichero de asistencia)
+void rebuildAttendance() {
+  attendanceCount = 0;
+  for (uint32_t seq = firstRecordSeq(); seq < (uint32_t)recordCount; seq++) {
+    updateAttendance(recordBySeq(seq));
+  }
+}
+
+#endif // ASISTENCIA_H
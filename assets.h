@@ -0,0 +1,178 @@
+/**
+ * assets.h
+ * Recursos estáticos de la interfaz web comprimidos con gzip.
+ * GENERADO por tools/gen_assets.py a partir de web_assets/: no editar a mano.
+ */
+
+#ifndef ASSETS_H
+#define ASSETS_H
+
+// /app.css: 947 bytes, 439 comprimido
+#define APP_CSS_ETAG "67e3e3fa"
+static const uint8_t appCssGz[] PROGMEM = {
+  0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x8D, 0x52, 0x4D, 0x6F, 0xDC, 0x20,
+  0x10, 0xBD, 0xFB, 0x57, 0x58, 0x8A, 0x7A, 0x5B, 0x47, 0xEC, 0x47, 0x93, 0x16, 0xAB, 0x87, 0xFC,
+  0x8E, 0x2A, 0x07, 0x0C, 0x83, 0x3D, 0x0A, 0x06, 0x0B, 0x70, 0xBC, 0xAE, 0xE5, 0xFF, 0x5E, 0xB0,
+  0xE9, 0x66, 0xAD, 0xB8, 0x52, 0x34, 0x17, 0x60, 0x66, 0xDE, 0xBC, 0xC7, 0xBC, 0xCA, 0x88, 0x71,
+  0x92, 0x46, 0xFB, 0x42, 0xB2, 0x16, 0xD5, 0x48, 0x5F, 0x2C, 0x32, 0x75, 0x70, 0x4C, 0xBB, 0xC2,
+  0x81, 0x45, 0x59, 0xB6, 0xCC, 0xD6, 0xA8, 0x29, 0x29, 0x3B, 0x26, 0x04, 0xEA, 0x9A, 0x9E, 0x48,
+  0x77, 0x2D, 0xB9, 0x51, 0xC6, 0xD2, 0x87, 0xF3, 0xF9, 0x3C, 0x67, 0xCD, 0x71, 0x4A, 0x57, 0x42,
+  0x9E, 0x9E, 0x38, 0x9F, 0xB3, 0xC7, 0x16, 0x74, 0x3F, 0x55, 0x8C, 0xBF, 0xD5, 0xD6, 0xF4, 0x5A,
+  0x14, 0x29, 0x2F, 0x49, 0x8C, 0x1B, 0xD2, 0x31, 0x22, 0xAD, 0xF8, 0x45, 0x65, 0xBC, 0x37, 0xED,
+  0x02, 0x9E, 0xFA, 0x73, 0x36, 0xA5, 0x9C, 0xC5, 0xBA, 0xF1, 0x6B, 0xF5, 0x66, 0x50, 0xE9, 0xE1,
+  0xEA, 0x0B, 0x01, 0xDC, 0x58, 0xE6, 0xD1, 0x68, 0xAA, 0x8D, 0x86, 0x1B, 0xFA, 0xF7, 0x3B, 0x24,
+  0xDA, 0x98, 0x77, 0xB0, 0x3B, 0x8C, 0x80, 0xC4, 0x08, 0x75, 0xCE, 0x33, 0xDF, 0xBB, 0xDD, 0x0A,
+  0xF9, 0x2C, 0xD9, 0x07, 0xE7, 0x00, 0x5B, 0x56, 0xC6, 0x0A, 0xB0, 0x85, 0x65, 0x02, 0x7B, 0x97,
+  0x06, 0x71, 0xA3, 0x25, 0xD6, 0x7B, 0xA2, 0x7F, 0xC6, 0xF8, 0x2A, 0x40, 0xEE, 0x9B, 0x69, 0x40,
+  0xE1, 0x1B, 0x7A, 0x21, 0xDF, 0x22, 0x2F, 0xE0, 0x51, 0x5A, 0xEE, 0xC5, 0xFF, 0xB9, 0x2D, 0xFB,
+  0x1B, 0x60, 0xF9, 0xA5, 0xCA, 0x28, 0x31, 0x67, 0x9E, 0x55, 0x0A, 0xA6, 0x34, 0x25, 0x14, 0x2B,
+  0xD6, 0x39, 0xA0, 0xFF, 0x0E, 0xE5, 0x3A, 0xE0, 0x48, 0xE2, 0x04, 0xDF, 0x1C, 0x22, 0xF6, 0x52,
+  0x4A, 0x8F, 0xDD, 0x35, 0x77, 0x46, 0xA1, 0xC8, 0x1F, 0x84, 0x10, 0x37, 0xCE, 0x3F, 0x02, 0xE5,
+  0xE5, 0xAF, 0x99, 0xC2, 0x5A, 0x53, 0x05, 0xD2, 0xC7, 0xC6, 0x3D, 0xB1, 0xA7, 0x18, 0x21, 0x69,
+  0x1F, 0x05, 0xE8, 0x31, 0xD2, 0x4E, 0x99, 0x8A, 0x10, 0x72, 0x22, 0x4B, 0x46, 0xC3, 0xB0, 0xAF,
+  0x47, 0x4A, 0x29, 0xE0, 0x79, 0xCE, 0x50, 0x77, 0xBD, 0xFF, 0xED, 0xC7, 0x0E, 0x7E, 0xC5, 0xB1,
+  0xAF, 0x87, 0xBB, 0x87, 0x8E, 0x39, 0x37, 0x04, 0xB6, 0xAF, 0xD3, 0x87, 0x8A, 0x0D, 0xD1, 0x64,
+  0xD8, 0x4B, 0x90, 0x42, 0x4A, 0x81, 0xAE, 0x53, 0x6C, 0xA4, 0xA8, 0x15, 0x6A, 0x28, 0x2A, 0x65,
+  0xF8, 0x5B, 0xF9, 0x59, 0x2C, 0x0F, 0x66, 0xDA, 0xEE, 0xE4, 0xB2, 0x6C, 0xE9, 0x5A, 0x38, 0xFC,
+  0x13, 0x81, 0x53, 0x32, 0xBC, 0x6C, 0xD8, 0xB9, 0xBE, 0x6A, 0x31, 0xF0, 0xAB, 0xFA, 0xE0, 0x5E,
+  0xBD, 0xA3, 0x28, 0x19, 0x75, 0xBD, 0x0D, 0x0D, 0x7A, 0xD8, 0xB8, 0x3F, 0xBF, 0x73, 0xC3, 0xEA,
+  0xDE, 0xCF, 0x2C, 0x78, 0x6F, 0x5D, 0x68, 0xEE, 0x0C, 0x6A, 0x0F, 0x76, 0xCE, 0xFE, 0x02, 0x74,
+  0x1F, 0xF9, 0xB8, 0xB3, 0x03, 0x00, 0x00
+};
+
+// /app.js: 5058 bytes, 2078 comprimido
+#define APP_JS_ETAG "2f416606"
+static const uint8_t appJsGz[] PROGMEM = {
+  0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x9D, 0x58, 0xDB, 0x72, 0x1B, 0xB9,
+  0x11, 0x7D, 0xF7, 0x57, 0xB4, 0x93, 0x8D, 0x30, 0xB3, 0xA1, 0x86, 0xB4, 0x2B, 0x5B, 0x9B, 0x48,
+  0x96, 0x5D, 0xBA, 0x96, 0xB5, 0xB1, 0x6C, 0xD7, 0x52, 0x5B, 0x79, 0x50, 0xF1, 0x01, 0x9C, 0x01,
+  0x49, 0xD8, 0xC3, 0x99, 0x59, 0x00, 0xA3, 0x8B, 0x77, 0xFD, 0x31, 0xF9, 0x80, 0x3C, 0xE5, 0x2D,
+  0xAF, 0xFE, 0xB1, 0x9C, 0x06, 0xE6, 0x46, 0x4A, 0x72, 0x5C, 0x79, 0x11, 0x31, 0xB8, 0x74, 0x37,
+  0xBA, 0x4F, 0x9F, 0x6E, 0x68, 0x3C, 0xA6, 0xF3, 0xC2, 0x29, 0xB3, 0x90, 0x9F, 0xE8, 0x46, 0xCD,
+  0x29, 0x53, 0x39, 0xA9, 0x75, 0x9D, 0xCB, 0xAC, 0x34, 0x74, 0x58, 0x5C, 0xEB, 0x4F, 0x7B, 0x94,
+  0x4B, 0x4B, 0xD5, 0x97, 0x7F, 0x2E, 0x75, 0x81, 0x81, 0x2D, 0x0B, 0xAA, 0x72, 0x59, 0x38, 0x9D,
+  0xF3, 0xFC, 0xFA, 0xCB, 0xBF, 0x0A, 0xBD, 0xC6, 0xE0, 0x8E, 0xF2, 0xD2, 0x3E, 0x19, 0x8F, 0x29,
+  0x93, 0xAE, 0xC4, 0x36, 0x45, 0x95, 0xCE, 0x54, 0x41, 0x12, 0xC7, 0xE9, 0xF0, 0xFD, 0x39, 0xFD,
+  0x34, 0x7D, 0xF7, 0x96, 0xA2, 0xB1, 0xAC, 0xF4, 0xF8, 0xFB, 0x18, 0xDB, 0x65, 0x4E, 0xA9, 0x2C,
+  0xF0, 0x37, 0x53, 0xA4, 0xAE, 0x55, 0xC1, 0xA7, 0xA2, 0xB1, 0x1F, 0xD9, 0x38, 0x79, 0x12, 0x2D,
+  0xEA, 0x22, 0x75, 0x1A, 0xDA, 0xA2, 0x98, 0x7E, 0x7B, 0x42, 0x24, 0x6A, 0xC8, 0xB4, 0xCE, 0xE8,
+  0xD4, 0x89, 0xFD, 0x27, 0x98, 0xE8, 0x36, 0x7C, 0x17, 0xE9, 0x0C, 0x7B, 0xC8, 0x28, 0x57, 0x9B,
+  0x82, 0xB2, 0x32, 0xAD, 0xD7, 0x90, 0x92, 0x2C, 0x95, 0x3B, 0xCD, 0x15, 0x0F, 0x8F, 0xEE, 0xCE,
+  0x33, 0xDE, 0xB4, 0x4F, 0x9F, 0x37, 0x4E, 0x2A, 0x9B, 0x46, 0x4E, 0xDD, 0xBA, 0xA0, 0x81, 0x5A,
+  0x09, 0x53, 0x68, 0x29, 0x96, 0x61, 0x25, 0x31, 0x0A, 0xD7, 0x4D, 0x55, 0x34, 0xBE, 0xDA, 0x79,
+  0xF1, 0xF2, 0x0F, 0x62, 0x36, 0x5E, 0x8E, 0x7A, 0x01, 0x51, 0xDA, 0x1E, 0xED, 0x0E, 0x8B, 0x9D,
+  0x3F, 0x0A, 0xFA, 0x33, 0xA5, 0x49, 0xBA, 0x92, 0xE6, 0xB8, 0xCC, 0xD4, 0xA1, 0x8B, 0x26, 0x31,
+  0x66, 0xC4, 0x3E, 0xEC, 0xE6, 0x8D, 0x9F, 0x63, 0xFE, 0xDD, 0xB4, 0x04, 0xB6, 0xFE, 0x04, 0xD7,
+  0x46, 0xB5, 0xC9, 0xB7, 0x8C, 0x59, 0x28, 0x97, 0xAE, 0x78, 0x7E, 0x84, 0x2B, 0xA6, 0x46, 0xC1,
+  0xA9, 0x4E, 0xCB, 0xDC, 0xEE, 0x91, 0xB0, 0x72, 0xAD, 0x76, 0x4B, 0xA3, 0x11, 0x19, 0x01, 0xA9,
+  0x89, 0x5B, 0xA9, 0x62, 0xE0, 0x37, 0xD3, 0xDB, 0xA6, 0x17, 0x14, 0x3D, 0x35, 0x49, 0xF9, 0x31,
+  0x26, 0xB7, 0x32, 0xE5, 0x0D, 0x15, 0xEA, 0x86, 0x4E, 0x8D, 0x29, 0x4D, 0x64, 0x12, 0xEB, 0xA4,
+  0xAB, 0x6D, 0xBC, 0xBF, 0x79, 0x0F, 0x93, 0x7C, 0x60, 0x83, 0xE2, 0xC7, 0x6D, 0x86, 0x9C, 0x28,
+  0x55, 0x79, 0x6E, 0x47, 0x94, 0xE6, 0xB6, 0x55, 0x76, 0x2D, 0x0D, 0x39, 0x43, 0x07, 0x7D, 0x1C,
+  0x60, 0xB4, 0x74, 0xAA, 0x09, 0x45, 0x24, 0x9C, 0x11, 0x8D, 0x50, 0xB6, 0xCA, 0x9F, 0x74, 0x26,
+  0x49, 0x81, 0x26, 0xFB, 0x16, 0x17, 0xC2, 0x49, 0xCC, 0x85, 0x0D, 0x98, 0xD7, 0x45, 0xA1, 0xCC,
+  0xEB, 0xCB, 0x8B, 0x37, 0x3C, 0xCF, 0xCA, 0x92, 0xB5, 0xAC, 0xA2, 0xCD, 0x00, 0x74, 0xAE, 0x7F,
+  0xE1, 0xB2, 0x97, 0xEC, 0x7C, 0x8E, 0x6B, 0xEA, 0x7D, 0xFE, 0x62, 0xCC, 0x53, 0xFB, 0xEC, 0x9D,
+  0x0F, 0xA5, 0x2E, 0x22, 0xD1, 0xEA, 0x6E, 0x8E, 0x38, 0x73, 0xFF, 0x5E, 0x0B, 0xA9, 0xF3, 0x48,
+  0xDD, 0x8B, 0x43, 0xA7, 0x52, 0xB1, 0x4A, 0x95, 0x27, 0x8C, 0x8F, 0xE3, 0x12, 0xD9, 0x53, 0x38,
+  0x18, 0x27, 0xBC, 0x3B, 0x03, 0xAC, 0xCD, 0x12, 0x4E, 0x08, 0x89, 0x10, 0x79, 0x7B, 0x92, 0xB5,
+  0xB2, 0x56, 0x2E, 0x15, 0x9B, 0x14, 0xB3, 0x39, 0x9D, 0x56, 0x76, 0xD7, 0xC5, 0xE9, 0xE5, 0xEB,
+  0x77, 0x27, 0x53, 0x08, 0xF9, 0x8D, 0x9E, 0x21, 0xAE, 0x2C, 0xD4, 0x48, 0xAB, 0x0A, 0x29, 0x46,
+  0xF4, 0x1C, 0x13, 0xAF, 0x6B, 0xDC, 0x5C, 0x52, 0x86, 0x48, 0x3B, 0x99, 0x63, 0xF2, 0xAF, 0x98,
+  0xBC, 0x94, 0xE6, 0x83, 0x72, 0x52, 0xB0, 0xB0, 0xA1, 0xF9, 0x6B, 0xE5, 0x56, 0x65, 0x16, 0xCD,
+  0x65, 0xFA, 0xB1, 0xAE, 0x06, 0xDE, 0x69, 0xB4, 0x5C, 0x85, 0x85, 0x19, 0xFD, 0xFE, 0x3B, 0x89,
+  0x77, 0xCE, 0x94, 0xA2, 0xC9, 0x0A, 0xE4, 0xEE, 0x91, 0x76, 0x96, 0xE6, 0xF2, 0x03, 0xEC, 0x66,
+  0x22, 0x70, 0xBA, 0x2A, 0x39, 0x3D, 0x8D, 0x5A, 0x6A, 0x64, 0x5E, 0xB9, 0x47, 0x13, 0xD8, 0xA8,
+  0xD8, 0xB8, 0x4C, 0x8E, 0xE8, 0x19, 0x3E, 0xAC, 0xCC, 0x75, 0x26, 0x29, 0x9A, 0x6B, 0x47, 0x3F,
+  0xE2, 0x5B, 0xA6, 0xA9, 0xB2, 0x25, 0xA5, 0xA5, 0x31, 0x2A, 0x75, 0x65, 0x3C, 0x34, 0x2C, 0xD3,
+  0x3C, 0x87, 0x51, 0xE4, 0xEE, 0x2A, 0x35, 0xB0, 0x2C, 0xF2, 0x13, 0xB4, 0x43, 0x93, 0xDB, 0x1F,
+  0xCF, 0x62, 0x3A, 0x38, 0x38, 0xA0, 0x67, 0x31, 0xBD, 0x22, 0x31, 0xF5, 0xD2, 0x05, 0xE1, 0xB6,
+  0xA7, 0x41, 0xEB, 0xC0, 0x58, 0x78, 0x69, 0xA1, 0xCD, 0x5A, 0xA6, 0xFA, 0xCB, 0xBF, 0x0B, 0xCF,
+  0x22, 0x05, 0x27, 0xAA, 0x85, 0xF2, 0x82, 0xED, 0x80, 0x22, 0xC5, 0xF7, 0x80, 0xE5, 0x35, 0xD4,
+  0x5E, 0x83, 0xA4, 0x22, 0xC4, 0x44, 0xEE, 0xA6, 0xE1, 0x20, 0xDB, 0xD6, 0x61, 0x54, 0x66, 0xD9,
+  0x29, 0x53, 0xCF, 0x1B, 0x5C, 0x54, 0x01, 0x71, 0x91, 0x48, 0x73, 0x9D, 0x7E, 0x14, 0xA3, 0xAD,
+  0xB8, 0x77, 0x10, 0x97, 0xEC, 0x89, 0xC4, 0x21, 0xD4, 0x0A, 0x08, 0x07, 0xF7, 0x41, 0x4F, 0x24,
+  0xE4, 0xD5, 0x50, 0xC3, 0x6C, 0x08, 0x74, 0x49, 0x3B, 0x3B, 0xF4, 0xB4, 0x59, 0x89, 0x24, 0xB3,
+  0xD3, 0xA1, 0x03, 0xD1, 0xCC, 0x6B, 0xA7, 0x22, 0x31, 0x3C, 0x26, 0xE2, 0x38, 0x86, 0xEC, 0xCA,
+  0x78, 0x32, 0x3C, 0x51, 0x0B, 0x59, 0xE7, 0x2E, 0x24, 0x22, 0xA7, 0x61, 0x03, 0x9A, 0x0A, 0x70,
+  0xB2, 0x0C, 0x99, 0x10, 0x7E, 0x38, 0xE4, 0x7D, 0xE0, 0x68, 0xAA, 0xC0, 0x5E, 0xA9, 0xAE, 0x64,
+  0xBE, 0x87, 0x44, 0x70, 0x60, 0x72, 0xB0, 0x6D, 0x05, 0x8A, 0xD7, 0x9E, 0x6B, 0xD7, 0x6A, 0x0D,
+  0xCA, 0x90, 0x38, 0xE2, 0x25, 0x34, 0xD9, 0x0F, 0x41, 0xDB, 0x84, 0x4B, 0x1D, 0x29, 0x09, 0xCF,
+  0xDA, 0x61, 0xA3, 0xB8, 0x47, 0x33, 0xB6, 0xA7, 0x19, 0xB6, 0x6B, 0x3D, 0x87, 0xAC, 0x67, 0x93,
+  0xE7, 0x7F, 0xA1, 0xEF, 0xFD, 0xCF, 0xFE, 0x60, 0x4D, 0x3B, 0xB5, 0x66, 0x55, 0x57, 0xCD, 0x1C,
+  0xD1, 0x95, 0x38, 0x61, 0x54, 0x70, 0xB0, 0xE8, 0xFC, 0x3D, 0xDC, 0x6D, 0x13, 0x5D, 0xCD, 0x46,
+  0x83, 0xF5, 0xB3, 0x5A, 0x99, 0x4F, 0x92, 0x2D, 0xE7, 0x84, 0xC8, 0xE9, 0x1F, 0xFA, 0x4C, 0xFB,
+  0x7D, 0xC6, 0x5A, 0xCD, 0xF9, 0x44, 0xD9, 0xD1, 0x5A, 0x6C, 0x1C, 0x99, 0x4E, 0xCF, 0x4F, 0xFC,
+  0x16, 0xEC, 0xC8, 0x36, 0x56, 0x7E, 0x3E, 0xBC, 0xA0, 0x37, 0x7A, 0x6E, 0x14, 0x96, 0x23, 0x9B,
+  0xAC, 0x94, 0xAC, 0x68, 0xEC, 0xCD, 0xC4, 0xB5, 0xCA, 0x33, 0x7D, 0xAB, 0xB2, 0xE8, 0xB9, 0x27,
+  0x0E, 0xFA, 0xFB, 0xD1, 0xA6, 0xD0, 0x33, 0x10, 0xD4, 0x8A, 0xA2, 0xE9, 0xFB, 0xF3, 0xB3, 0xB3,
+  0x69, 0x3C, 0x94, 0xB2, 0xB0, 0x67, 0x46, 0x29, 0xC8, 0x59, 0xCF, 0xEF, 0x49, 0x19, 0x13, 0xE7,
+  0xBF, 0xDF, 0x74, 0x59, 0x22, 0x77, 0x1F, 0xDE, 0x75, 0xB1, 0xA5, 0xEB, 0x17, 0x5B, 0x4B, 0xA3,
+  0x91, 0x85, 0x4D, 0xE6, 0x21, 0x86, 0xD6, 0x5F, 0x08, 0x35, 0xD0, 0xD8, 0xCD, 0x1B, 0x35, 0xB9,
+  0xC9, 0x48, 0x6F, 0xB2, 0x2F, 0x78, 0x47, 0x21, 0x07, 0x33, 0xEB, 0xC5, 0x47, 0x45, 0xAD, 0xAE,
+  0x4B, 0xAE, 0x18, 0xF8, 0xB4, 0x09, 0xB8, 0xFF, 0xE7, 0x7E, 0x35, 0xDE, 0xBA, 0xA6, 0x42, 0xDD,
+  0x02, 0x60, 0x56, 0xA5, 0x91, 0x5E, 0x90, 0xD3, 0x6B, 0x35, 0x6B, 0x36, 0xCC, 0xDA, 0x60, 0x7E,
+  0x17, 0x89, 0x0E, 0x0E, 0x43, 0x86, 0xF6, 0x01, 0xDE, 0x62, 0x68, 0xDD, 0xE3, 0xA3, 0x2F, 0x92,
+  0x2F, 0xAA, 0x8E, 0xA8, 0xF5, 0xD5, 0x64, 0xE6, 0xDD, 0x10, 0xEC, 0x0B, 0x53, 0xCF, 0x66, 0x0D,
+  0x7D, 0x63, 0x5F, 0xAB, 0xF4, 0x1E, 0x87, 0x37, 0x80, 0x53, 0x6B, 0x68, 0x86, 0x45, 0x18, 0xF4,
+  0x2B, 0xB0, 0x42, 0xAD, 0x93, 0x45, 0x69, 0x4E, 0x25, 0xCA, 0x67, 0x6F, 0x4D, 0x35, 0xB4, 0x86,
+  0xB7, 0xC8, 0xAA, 0x52, 0x45, 0x76, 0xBC, 0xD2, 0x79, 0x16, 0x71, 0x45, 0xBB, 0xAA, 0x92, 0xB2,
+  0x1A, 0x51, 0x15, 0xC0, 0xC1, 0xEE, 0x3B, 0x12, 0xFC, 0x39, 0xCF, 0xCB, 0xF4, 0xE3, 0xE0, 0x7B,
+  0x61, 0xE4, 0xD2, 0x7F, 0xFE, 0xC9, 0x7F, 0xC2, 0x1D, 0x1B, 0xCB, 0xA8, 0xCD, 0x55, 0xAE, 0xEC,
+  0x2C, 0x8E, 0x7B, 0xF3, 0xDB, 0x52, 0x9A, 0xA4, 0x92, 0x6B, 0xBA, 0xAF, 0x33, 0x03, 0x4F, 0x86,
+  0xAD, 0xF7, 0xD2, 0x19, 0x71, 0xAD, 0x1B, 0x3C, 0xEC, 0x71, 0xCE, 0x62, 0x0E, 0x8C, 0x5B, 0xA1,
+  0xD6, 0xA4, 0xB5, 0xB1, 0xA5, 0xE9, 0x32, 0xD9, 0x83, 0xE3, 0xC1, 0x44, 0xF6, 0x35, 0x59, 0xCE,
+  0x73, 0x15, 0x1C, 0xE5, 0x37, 0xB6, 0xAE, 0xF2, 0x2E, 0x2C, 0x4D, 0xB3, 0xC4, 0xA3, 0xE1, 0x4A,
+  0x50, 0xC1, 0xE5, 0xAD, 0x09, 0x43, 0x27, 0x3C, 0x2F, 0x65, 0x16, 0xF5, 0xCE, 0xE4, 0x83, 0xC9,
+  0x4A, 0x67, 0xDC, 0xF3, 0x1D, 0xA0, 0xAC, 0xD6, 0xAA, 0xBD, 0xF7, 0x26, 0x8B, 0x78, 0xDD, 0xAF,
+  0x72, 0xBD, 0xD6, 0xEE, 0xE0, 0x87, 0xC9, 0x4E, 0x90, 0x7F, 0xE0, 0x3B, 0x26, 0x3F, 0xFC, 0x5A,
+  0x17, 0x03, 0xF8, 0x84, 0x4B, 0x3E, 0x10, 0xD7, 0x7A, 0xB8, 0x8D, 0xC2, 0x6D, 0xEF, 0xC7, 0xB6,
+  0x4E, 0x74, 0x36, 0xA2, 0x3A, 0x29, 0xD0, 0x68, 0xF0, 0x2F, 0x4A, 0xB5, 0xFF, 0xCE, 0x54, 0xE5,
+  0xF8, 0x57, 0x72, 0xA1, 0x50, 0x5C, 0x7A, 0x0E, 0x79, 0x54, 0xFA, 0xD2, 0x73, 0x5E, 0xC8, 0xF0,
+  0x31, 0x08, 0x66, 0x1F, 0xCE, 0x96, 0xDF, 0x0D, 0x92, 0x9A, 0x13, 0x9C, 0xAB, 0x17, 0xFA, 0x3D,
+  0xF6, 0xA5, 0x5D, 0x32, 0x5B, 0x6E, 0x76, 0x09, 0x6F, 0x4B, 0x5A, 0xC9, 0xBB, 0x2E, 0xA2, 0xC3,
+  0x0C, 0x4F, 0xE8, 0x17, 0x74, 0xD5, 0x3A, 0x45, 0x25, 0xCB, 0xD1, 0x67, 0x2F, 0xDC, 0x8D, 0x44,
+  0x58, 0x7C, 0x13, 0x4E, 0xC7, 0xC8, 0x70, 0x7B, 0xBC, 0x52, 0xB7, 0x88, 0xB5, 0x91, 0x84, 0xC6,
+  0x19, 0xD5, 0xB4, 0x93, 0x92, 0x88, 0x6D, 0x5B, 0x0A, 0x68, 0xA5, 0xA7, 0x30, 0xA5, 0xA8, 0x73,
+  0xEE, 0x64, 0xFA, 0x40, 0x86, 0xB5, 0xFD, 0xAD, 0x80, 0x2D, 0xD0, 0x51, 0x2A, 0xAE, 0xAD, 0x5D,
+  0xAA, 0x6D, 0x62, 0xD4, 0xDF, 0xA5, 0xBD, 0x7E, 0xD8, 0xE5, 0x05, 0x94, 0x85, 0xAF, 0x93, 0x90,
+  0xC0, 0x78, 0x08, 0xCB, 0x01, 0x19, 0x8F, 0x61, 0xB9, 0x6D, 0x26, 0x00, 0xE6, 0x2F, 0xFF, 0xC9,
+  0xC1, 0x2E, 0x70, 0xC2, 0x0F, 0x13, 0x30, 0x4E, 0x20, 0xA9, 0x86, 0xC3, 0x2C, 0xAA, 0x39, 0x5D,
+  0xC3, 0xE9, 0x1D, 0xBA, 0x5B, 0x42, 0xFB, 0x06, 0x7C, 0x37, 0x5B, 0x87, 0x38, 0x46, 0x5D, 0xB5,
+  0xEC, 0xFF, 0x80, 0x0B, 0x60, 0xC1, 0x82, 0x75, 0xB6, 0x10, 0x8D, 0x82, 0xCB, 0x70, 0x89, 0x1C,
+  0x43, 0xAE, 0xD9, 0xA9, 0x0B, 0xE0, 0xCD, 0x1D, 0x29, 0x00, 0x4E, 0x61, 0x61, 0x14, 0x04, 0x79,
+  0x17, 0x4E, 0xF5, 0x3C, 0xC7, 0x33, 0x21, 0x6E, 0xBD, 0xF6, 0x7F, 0x55, 0xCB, 0x2E, 0x2C, 0x17,
+  0xD2, 0xAD, 0x40, 0x9C, 0xB7, 0x5C, 0x2A, 0x58, 0xC5, 0x54, 0xFD, 0x3A, 0xF2, 0x5C, 0x7D, 0xCB,
+  0x43, 0xDA, 0x85, 0x8F, 0x3A, 0xC0, 0x71, 0x88, 0x07, 0x0E, 0xF9, 0x26, 0xC0, 0x99, 0xFB, 0x75,
+  0x22, 0xA1, 0x37, 0x3D, 0x00, 0xC3, 0x9B, 0x6D, 0xC9, 0xBD, 0x0F, 0x00, 0x56, 0xC0, 0x30, 0x59,
+  0xA0, 0x73, 0x40, 0x63, 0xD3, 0x63, 0xB5, 0x0E, 0xF0, 0x2C, 0xC8, 0xA2, 0x61, 0x70, 0xA1, 0xFD,
+  0x1C, 0x60, 0x4F, 0x01, 0x42, 0x5B, 0xB6, 0xBD, 0x64, 0xB3, 0x1F, 0x35, 0xED, 0xA2, 0x64, 0xE4,
+  0x77, 0x6A, 0x7A, 0x30, 0x6C, 0x18, 0x5B, 0xA3, 0x4B, 0xF7, 0x99, 0x85, 0x71, 0x28, 0x60, 0x83,
+  0xDA, 0xD6, 0x6B, 0x6F, 0x2A, 0xCB, 0x66, 0x14, 0x9A, 0x9D, 0x5F, 0xE3, 0x9B, 0x8E, 0x94, 0x1F,
+  0xE7, 0x1D, 0xD3, 0x6A, 0x7C, 0x80, 0x77, 0xB0, 0x32, 0x64, 0x9E, 0x16, 0x43, 0x9E, 0x6D, 0xB0,
+  0xE6, 0xF9, 0x6A, 0x44, 0x3C, 0x62, 0xCE, 0xF1, 0x4D, 0xB7, 0x08, 0xDF, 0x5C, 0x58, 0x47, 0x83,
+  0xA6, 0xD8, 0xCF, 0x71, 0x63, 0x3C, 0x6A, 0x5B, 0x78, 0x9E, 0x69, 0xDA, 0xF8, 0x6F, 0xA9, 0x23,
+  0x5D, 0x8E, 0x76, 0x3D, 0xE7, 0xD3, 0x1B, 0x0D, 0xEF, 0xDE, 0x24, 0xBE, 0xB5, 0x9D, 0x96, 0xB5,
+  0x49, 0xD1, 0xC3, 0x06, 0x47, 0xF5, 0xA9, 0x11, 0x9E, 0xDC, 0x88, 0x87, 0x7F, 0x13, 0xF6, 0x3B,
+  0xE1, 0xC2, 0xB0, 0xD4, 0xE6, 0x51, 0xF8, 0x7A, 0xA0, 0x55, 0xF6, 0x70, 0xB2, 0x0F, 0xF7, 0xCA,
+  0xAD, 0x0E, 0xC8, 0xE7, 0xFF, 0x00, 0x24, 0xA0, 0x2F, 0xAB, 0x22, 0x95, 0x70, 0xC3, 0xBB, 0x51,
+  0xC6, 0x6F, 0x56, 0x9E, 0x88, 0xD8, 0x88, 0x13, 0x3C, 0x17, 0x23, 0x75, 0x9D, 0xC0, 0x2A, 0xEE,
+  0x21, 0x27, 0x13, 0x6E, 0x98, 0xCE, 0xA7, 0xEF, 0x9A, 0x77, 0x79, 0xFF, 0x26, 0x17, 0x97, 0x50,
+  0x2A, 0xD0, 0xC3, 0x24, 0xB6, 0x9E, 0x03, 0x30, 0xD1, 0x04, 0xAF, 0x92, 0xBF, 0x6D, 0xE4, 0x09,
+  0xC4, 0x18, 0x9F, 0x22, 0x62, 0x09, 0xA8, 0x39, 0xF1, 0x68, 0xB0, 0xB0, 0x31, 0xC4, 0x0A, 0x83,
+  0x50, 0x1E, 0xD8, 0xA2, 0x61, 0x80, 0xD8, 0xA2, 0x10, 0x9F, 0xEE, 0xED, 0x35, 0xC3, 0x18, 0x16,
+  0x8B, 0x41, 0x74, 0xFA, 0x34, 0xE8, 0x55, 0xDB, 0x74, 0xA5, 0xB2, 0x3A, 0x57, 0x82, 0xE3, 0xDF,
+  0x4F, 0x57, 0x78, 0xF2, 0x72, 0x7C, 0x37, 0x8C, 0x62, 0x5F, 0xE0, 0xC1, 0xCC, 0xFF, 0x67, 0x39,
+  0xA0, 0x87, 0x44, 0xBC, 0xE2, 0x8E, 0x6E, 0x81, 0xAE, 0xD8, 0xD3, 0x29, 0xF7, 0x69, 0x48, 0xCE,
+  0xD8, 0x57, 0x2A, 0xBC, 0x32, 0x0A, 0xA7, 0x77, 0x5B, 0xB9, 0xF1, 0xA0, 0x2C, 0x7C, 0xF5, 0xAE,
+  0xC8, 0x86, 0xA0, 0xB2, 0xBD, 0xB4, 0xD8, 0x15, 0x5B, 0xB7, 0x44, 0x99, 0xB8, 0xFB, 0x5F, 0xD7,
+  0xAC, 0x0B, 0xEE, 0x91, 0x1E, 0x77, 0x71, 0x90, 0x7A, 0x88, 0xB7, 0x08, 0x10, 0x28, 0xA1, 0x72,
+  0x8D, 0xBC, 0x16, 0x9B, 0x3A, 0x77, 0x1F, 0xF7, 0xE9, 0x57, 0xA5, 0x36, 0xB6, 0x86, 0x16, 0xF2,
+  0xDA, 0x17, 0xF6, 0xF0, 0x38, 0x00, 0x44, 0x97, 0xFC, 0x70, 0xFC, 0xF6, 0xAB, 0x0D, 0xFF, 0xE1,
+  0xE1, 0x93, 0xE9, 0x2B, 0xAF, 0xC4, 0x93, 0x77, 0x17, 0x0D, 0xA1, 0xBD, 0x41, 0xD5, 0x53, 0xD9,
+  0x46, 0x12, 0x0C, 0xCB, 0x13, 0x17, 0x31, 0x04, 0xD4, 0xD7, 0xB2, 0xAB, 0x4E, 0xE0, 0xBC, 0xCC,
+  0xEE, 0x1E, 0x7A, 0x09, 0xF2, 0x36, 0x11, 0xCF, 0xFA, 0xD7, 0x23, 0x4F, 0xC4, 0xFE, 0x74, 0xFF,
+  0x10, 0xFC, 0x1C, 0xF3, 0xF8, 0xBF, 0x18, 0xB4, 0x1C, 0x8E, 0xC2, 0x13, 0x00, 0x00
+};
+
+#endif // ASSETS_H
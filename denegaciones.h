@@ -0,0 +1,98 @@
+/**
+ * denegaciones.h
+ * Tarjetas desconocidas: caché negativa, limitador de intentos por lector y
+ * registro circular de denegaciones para auditoría
+ */
+
+#ifndef DENEGACIONES_H
+#define DENEGACIONES_H
+
+#define NEGATIVE_CACHE_SIZE 64        // Tarjetas desconocidas recordadas (potencia de 2)
+#define DENIAL_LOG_SIZE 64            // Entradas del registro de denegaciones
+#define DENIAL_BURST 5                // Intentos denegados seguidos permitidos por lector
+#define DENIAL_REFILL_INTERVAL 2000   // Una ficha más cada este tiempo (ms)
+
+// ========= CACHÉ NEGATIVA ===========
+// Correspondencia directa: cada tarjeta solo puede estar en una posición, así
+// que consultar y añadir cuesta O(1). Una colisión sustituye la entrada
+// anterior. Se vacía cuando cambia la tabla de usuarios.
+uint32_t negativeCache[NEGATIVE_CACHE_SIZE];
+uint32_t negativeCacheGeneration = UINT32_MAX;
+
+int negativeCacheSlot(uint32_t cardId) {
+  return (cardId * 2654435761UL) >> 26;  // Hash multiplicativo, 6 bits
+}
+
+// ¿Se sabe ya que la tarjeta no pertenece a ningún usuario activo?
+bool negativeCacheContains(uint32_t cardId) {
+  if (negativeCacheGeneration != userTableGeneration) {
+    memset(negativeCache, 0, sizeof(negativeCache));
+    negativeCacheGeneration = userTableGeneration;
+    return false;
+  }
+  // La tarjeta 0 marca posición libre: nunca se considera en caché
+  return cardId != 0 && negativeCache[negativeCacheSlot(cardId)] == cardId;
+}
+
+void negativeCacheAdd(uint32_t cardId) {
+  negativeCache[negativeCacheSlot(cardId)] = cardId;
+}
+
+// ========= LIMITADOR POR LECTOR ===========
+RateLimiter readerLimiters[MAX_READERS];
+
+// Consumir una ficha del lector. Devuelve false si se ha agotado: el intento
+// se descarta sin secuencia de LED ni evento.
+bool readerRateAllows(uint8_t reader) {
+  RateLimiter& limiter = readerLimiters[reader];
+  uint32_t nowMs = millis();
+  if (limiter.lastRefill == 0) {
+    limiter.tokens = DENIAL_BURST;
+    limiter.lastRefill = nowMs;
+  }
+  uint32_t refills = (nowMs - limiter.lastRefill) / DENIAL_REFILL_INTERVAL;
+  if (refills > 0) {
+    uint32_t tokens = limiter.tokens + refills;
+    limiter.tokens = (tokens > DENIAL_BURST) ? DENIAL_BURST : tokens;
+    limiter.lastRefill += refills * DENIAL_REFILL_INTERVAL;
+  }
+  if (limiter.tokens == 0) return false;
+  limiter.tokens--;
+  return true;
+}
+
+// ========= REGISTRO DE DENEGACIONES ===========
+DenialEntry denialLog[DENIAL_LOG_SIZE];
+uint32_t denialLogCount = 0;    // Entradas escritas (la más reciente es denialLogCount - 1)
+
+const char* denyReasonName(uint8_t reason) {
+  switch (reason) {
+    case DENY_UNKNOWN: return "unknown";
+    case DENY_SCHEDULE: return "schedule";
+    case DENY_PASSBACK: return "passback";
+    case DENY_THROTTLED: return "throttled";
+    default: return "other";
+  }
+}
+
+// Anotar una denegación. Un barrido con la misma tarjeta solo ocupa una entrada.
+void logDenial(uint32_t cardId, uint8_t reason, uint8_t reader) {
+  uint32_t timestamp = now() - 946684800;
+  if (denialLogCount > 0) {
+    DenialEntry& last = denialLog[(denialLogCount - 1) % DENIAL_LOG_SIZE];
+    if (last.cardId == cardId && last.reason == reason && last.reader == reader && last.attempts < UINT16_MAX) {
+      last.attempts++;
+      last.timestamp = timestamp;
+      return;
+    }
+  }
+  DenialEntry& entry = denialLog[denialLogCount % DENIAL_LOG_SIZE];
+  entry.timestamp = timestamp;
+  entry.cardId = cardId;
+  entry.attempts = 1;
+  entry.reason = reason;
+  entry.reader = reader;
+  denialLogCount++;
+}
+
+#endif // DENEGACIONES_H
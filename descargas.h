@@ -0,0 +1,158 @@
+/**
+ * descargas.h
+ * Cursores de descarga de registros (0x40) por cliente, confirmados y
+ * guardados en flash para retomar una sincronización interrumpida
+ */
+
+#ifndef DESCARGAS_H
+#define DESCARGAS_H
+
+#define DOWNLOAD_CURSOR_SAVE_INTERVAL 10000 // Mínimo entre escrituras de los cursores en flash (ms)
+#define DOWNLOAD_MAX_FRAMES (BULK_MAX_PAGES + 1) // Tramas de 0x40 en vuelo (una respuesta masiva y una a medias)
+
+// Declaración de funciones externas (definidas en almacenamiento.h)
+extern void saveDownloadCursors();
+
+// Declaración de variables externas (definidas en sesion.h)
+extern uint32_t txWrittenTotal;
+
+// Cada cliente se identifica por su IP. Un lote enviado queda en vuelo hasta
+// que el mismo cliente, por la misma conexión, manda cualquier otro comando:
+// el protocolo es de petición y respuesta, así que eso prueba que recibió la
+// respuesta anterior. Solo se confirman las tramas que ya habían salido de
+// la cola de transmisión (sesion.h) en ese momento: en modo masivo puede
+// haber tramas encoladas que el cliente aún no ha visto. Si la conexión se
+// corta antes, el lote no se confirma y se vuelve a enviar al reanudar.
+DownloadCursor downloadCursors[MAX_DOWNLOAD_CLIENTS];
+uint32_t downloadCursorClock = 0;      // Contador de uso (lastUsed)
+int downloadInFlight = -1;             // Cursor con un lote sin confirmar en esta conexión
+
+// Tramas de registros en vuelo, en orden: dónde termina cada una en el flujo
+// TCP y la secuencia siguiente a su último registro
+typedef struct {
+  uint32_t txEnd;
+  uint32_t seqEnd;
+} DownloadFrame;
+
+DownloadFrame downloadFrames[DOWNLOAD_MAX_FRAMES];
+uint8_t downloadFrameCount = 0;
+// Hay cambios por guardar: clientes nuevos o posiciones confirmadas. El
+// avance de sent no cuenta, al arrancar se vuelve a partir de acked.
+bool downloadCursorsDirty = false;
+unsigned long downloadCursorsSavedAt = 0;
+
+// Mantener un cursor dentro del almacén: registros sobrescritos o borrados
+// Devuelve si ha cambiado algo.
+bool clampDownloadCursor(DownloadCursor& cursor) {
+  uint32_t first = firstRecordSeq();
+  uint32_t last = recordCount;
+  uint32_t sent = cursor.sent;
+  uint32_t acked = cursor.acked;
+  if (cursor.sent < first) cursor.sent = first;
+  if (cursor.sent > last) cursor.sent = last;
+  if (cursor.acked < first) cursor.acked = first;
+  if (cursor.acked > last) cursor.acked = last;
+  return cursor.sent != sent || cursor.acked != acked;
+}
+
+// Llamar tras borrar los registros: ningún cursor queda antes de recordBase
+void clampDownloadCursors() {
+  for (int i = 0; i < MAX_DOWNLOAD_CLIENTS; i++) {
+    if (downloadCursors[i].ip == 0) continue;
+    if (clampDownloadCursor(downloadCursors[i])) downloadCursorsDirty = true;
+  }
+}
+
+// Cursor del cliente conectado. Un cliente nuevo ocupa el hueco libre o el
+// del cliente usado hace más tiempo, y empieza por los registros nuevos.
+int downloadCursorForClient() {
+  uint32_t ip = client.remoteIP();
+  int slot = -1;
+  int oldest = 0;
+  for (int i = 0; i < MAX_DOWNLOAD_CLIENTS; i++) {
+    if (downloadCursors[i].ip == ip) {
+      slot = i;
+      break;
+    }
+    if (downloadCursors[i].lastUsed < downloadCursors[oldest].lastUsed) oldest = i;
+  }
+  if (slot < 0) {
+    int pending = (newRecordCount < storedRecordCount()) ? newRecordCount : storedRecordCount();
+    slot = oldest;
+    downloadCursors[slot].ip = ip;
+    downloadCursors[slot].sent = recordCount - pending;
+    downloadCursors[slot].acked = recordCount - pending;
+    downloadCursorsDirty = true;
+  }
+  DownloadCursor& cursor = downloadCursors[slot];
+  cursor.lastUsed = ++downloadCursorClock;
+  if (clampDownloadCursor(cursor)) downloadCursorsDirty = true;
+  return slot;
+}
+
+// Confirmar que el cliente tiene todos los registros anteriores a seq. Los
+// registros nuevos solo dejan de contarse como tales al confirmarse.
+void acknowledgeDownload(DownloadCursor& cursor, uint32_t seq) {
+  if (seq <= cursor.acked) return;
+  cursor.acked = seq;
+  int pending = recordCount - seq;
+  if (newRecordCount > pending) newRecordCount = pending;
+  downloadCursorsDirty = true;
+}
+
+// Anotar una trama de registros ya encolada. Sin hueco en la lista, la trama
+// no llega a confirmarse y se reenvía en la próxima sesión.
+void noteDownloadFrame(int slot, uint32_t txEnd, uint32_t seqEnd) {
+  if (downloadInFlight != slot) downloadFrameCount = 0;
+  downloadInFlight = slot;
+  if (downloadFrameCount < DOWNLOAD_MAX_FRAMES) {
+    downloadFrames[downloadFrameCount].txEnd = txEnd;
+    downloadFrames[downloadFrameCount].seqEnd = seqEnd;
+    downloadFrameCount++;
+  }
+}
+
+// Llamar al recibir un comando válido: confirma las tramas enviadas antes que
+// ya salieron completas de la cola. Las demás siguen en vuelo.
+void confirmDownloadInFlight() {
+  if (downloadInFlight < 0) return;
+  int delivered = 0;
+  while (delivered < downloadFrameCount && (int32_t)(downloadFrames[delivered].txEnd - txWrittenTotal) <= 0) {
+    delivered++;
+  }
+  if (delivered > 0) {
+    acknowledgeDownload(downloadCursors[downloadInFlight], downloadFrames[delivered - 1].seqEnd);
+    memmove(downloadFrames, &downloadFrames[delivered], (downloadFrameCount - delivered) * sizeof(DownloadFrame));
+    downloadFrameCount -= delivered;
+  }
+  if (downloadFrameCount == 0) downloadInFlight = -1;
+}
+
+// Llamar al quitar de la cola las tramas encoladas desde txPosition: dejan de
+// estar en vuelo y el cursor vuelve a seq, el primer registro que no salió
+void rewindDownloadInFlight(uint32_t txPosition, uint32_t seq) {
+  if (downloadInFlight < 0) return;
+  while (downloadFrameCount > 0 && (int32_t)(downloadFrames[downloadFrameCount - 1].txEnd - txPosition) > 0) {
+    downloadFrameCount--;
+  }
+  downloadCursors[downloadInFlight].sent = seq;
+  if (downloadFrameCount == 0) downloadInFlight = -1;
+}
+
+// Llamar al aceptar una conexión TCP nueva: un lote de la conexión anterior
+// sin confirmar se vuelve a enviar al continuar la descarga
+void resetDownloadSession() {
+  if (downloadInFlight < 0) return;
+  downloadCursors[downloadInFlight].sent = downloadCursors[downloadInFlight].acked;
+  downloadInFlight = -1;
+  downloadFrameCount = 0;
+}
+
+// Llamar en cada iteración del loop
+void pumpDownloadCursors() {
+  if (downloadCursorsDirty && millis() - downloadCursorsSavedAt > DOWNLOAD_CURSOR_SAVE_INTERVAL) {
+    saveDownloadCursors();
+  }
+}
+
+#endif // DESCARGAS_H
@@ -0,0 +1,90 @@
+/**
+ * diagnostico.h
+ * Perfilado de memoria: marcas de agua de heap y pila por operación
+ */
+
+#ifndef DIAGNOSTICO_H
+#define DIAGNOSTICO_H
+
+// ========= VARIABLES DE PERFILADO ===========
+MemProfile memProfiles[MEM_OP_COUNT];          // Peores valores por operación
+MemOperation currentMemOperation = MEM_OP_LOOP; // Operación en curso
+uint8_t memProfileDepth = 0;                    // Ámbitos de perfilado abiertos
+
+// Nombres legibles de cada operación (mismo orden que MemOperation)
+const char* memOperationName(MemOperation op) {
+  switch (op) {
+    case MEM_OP_LOOP: return "Loop";
+    case MEM_OP_SYNC: return "Sincronizacion";
+    case MEM_OP_SAVE: return "Guardado";
+    case MEM_OP_WEB: return "Pagina web";
+    default: return "Desconocida";
+  }
+}
+
+// Reiniciar todas las marcas de agua
+void resetMemProfiles() {
+  for (int i = 0; i < MEM_OP_COUNT; i++) {
+    memProfiles[i].minFreeHeap = UINT32_MAX;
+    memProfiles[i].minMaxBlock = UINT32_MAX;
+    memProfiles[i].maxFragmentation = 0;
+    memProfiles[i].minFreeStack = UINT32_MAX;
+    memProfiles[i].samples = 0;
+  }
+}
+
+// Tomar una muestra y atribuirla a la operación en curso.
+// Llamar en los puntos de máximo consumo (p. ej. con un JsonDocument grande vivo).
+void memProfileSample() {
+  MemProfile& p = memProfiles[currentMemOperation];
+
+  uint32_t freeHeap = ESP.getFreeHeap();
+  uint32_t maxBlock = ESP.getMaxFreeBlockSize();
+  uint8_t fragmentation = ESP.getHeapFragmentation();
+  // getFreeContStack() devuelve la pila nunca usada desde el último repintado,
+  // por lo que ya es una marca de agua y no solo el valor instantáneo.
+  uint32_t freeStack = ESP.getFreeContStack();
+
+  if (freeHeap < p.minFreeHeap) p.minFreeHeap = freeHeap;
+  if (maxBlock < p.minMaxBlock) p.minMaxBlock = maxBlock;
+  if (fragmentation > p.maxFragmentation) p.maxFragmentation = fragmentation;
+  if (freeStack < p.minFreeStack) p.minFreeStack = freeStack;
+  p.samples++;
+}
+
+// Empezar a atribuir las muestras a una operación. Devuelve la operación
+// anterior, que se pasa a memProfileEnd() al terminar.
+// Solo el ámbito más exterior repinta la pila: hacerlo dentro de otro
+// borraría la marca de agua que el exterior aún no ha anotado. En un ámbito
+// anidado la pila medida incluye la que ya usaba el exterior (cota superior).
+MemOperation memProfileBegin(MemOperation op) {
+  MemOperation previous = currentMemOperation;
+  memProfileSample();           // Cerrar la medición de la operación exterior
+  currentMemOperation = op;
+  if (memProfileDepth++ == 0) {
+    ESP.resetFreeContStack();   // Repintar la pila para medir solo esta operación
+  }
+  memProfileSample();
+  return previous;
+}
+
+void memProfileEnd(MemOperation previous) {
+  memProfileSample();
+  if (memProfileDepth > 0) memProfileDepth--;
+  currentMemOperation = previous;
+}
+
+// Ámbito de perfilado: atribuye todas las muestras tomadas mientras vive a
+// una operación y restaura la anterior al salir (soporta anidamiento, p. ej.
+// un guardado disparado dentro de una sincronización).
+struct MemProfileScope {
+  MemOperation previous;
+
+  explicit MemProfileScope(MemOperation op) : previous(memProfileBegin(op)) {}
+
+  ~MemProfileScope() {
+    memProfileEnd(previous);
+  }
+};
+
+#endif // DIAGNOSTICO_H
@@ -0,0 +1,58 @@
+/**
+ * diario.h
+ * Versiones de usuario y diario acotado de cambios para que el software de
+ * sincronización descargue solo lo modificado desde su última versión
+ */
+
+#ifndef DIARIO_H
+#define DIARIO_H
+
+// Cada alta, modificación o baja recibe la siguiente versión global y se
+// anota en un anillo. Un cliente que conoce la versión V pide los cambios
+// posteriores; si el anillo ya ha descartado alguno de ellos debe volver a
+// descargar la tabla completa.
+UserChange userJournal[USER_JOURNAL_SIZE];
+uint32_t userJournalCount = 0;  // Cambios anotados en total (posición de escritura)
+uint32_t userVersion = 0;       // Última versión asignada
+uint32_t userJournalBase = 0;   // El diario tiene todos los cambios posteriores a esta versión
+
+// Anotar un cambio y devolver su versión. Llamar en cada modificación de
+// users[]; en altas y modificaciones la versión se guarda también en el usuario.
+uint32_t noteUserChange(const uint8_t* id, uint8_t op) {
+  UserChange& change = userJournal[userJournalCount % USER_JOURNAL_SIZE];
+  if (userJournalCount >= USER_JOURNAL_SIZE) {
+    // Se descarta el cambio más antiguo
+    userJournalBase = change.version;
+  }
+  change.version = ++userVersion;
+  memcpy(change.id, id, 5);
+  change.op = op;
+  userJournalCount++;
+  return userVersion;
+}
+
+// ¿Se pueden servir los cambios posteriores a la versión since? Una versión
+// futura (tabla borrada o equipo sustituido) también obliga a resincronizar.
+bool userJournalCovers(uint32_t since) {
+  return since >= userJournalBase && since <= userVersion;
+}
+
+// Posición (en cambios anotados) del primer cambio posterior a since
+uint32_t userJournalFind(uint32_t since) {
+  uint32_t stored = (userJournalCount < USER_JOURNAL_SIZE) ? userJournalCount : USER_JOURNAL_SIZE;
+  uint32_t pos = userJournalCount - stored;
+  while (pos < userJournalCount && userJournal[pos % USER_JOURNAL_SIZE].version <= since) {
+    pos++;
+  }
+  return pos;
+}
+
+const char* userChangeOpName(uint8_t op) {
+  switch (op) {
+    case USER_CHANGE_ADD: return "add";
+    case USER_CHANGE_DELETE: return "delete";
+    default: return "update";
+  }
+}
+
+#endif // DIARIO_H
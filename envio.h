@@ -0,0 +1,246 @@
+/**
+ * envio.h
+ * Envío de registros nuevos a un colector (TCP en formato Anviz o HTTP con
+ * JSON) en lotes, con confirmación por número de secuencia y reintentos
+ */
+
+#ifndef ENVIO_H
+#define ENVIO_H
+
+#define PUSH_MAX_BATCH 25             // Como una respuesta de 0x40
+#define PUSH_LINGER 500               // Espera para agrupar registros en un lote (ms)
+#define PUSH_CONNECT_TIMEOUT 300      // Tiempo máximo de conexión; bloquea el loop (ms)
+#define PUSH_ACK_TIMEOUT 5000         // Tiempo máximo para recibir la confirmación (ms)
+#define PUSH_BACKOFF_MIN 1000         // Primer reintento tras un fallo (ms)
+#define PUSH_BACKOFF_MAX 60000        // Máximo entre reintentos (ms)
+#define PUSH_CURSOR_SAVE_INTERVAL 10000 // Mínimo entre escrituras del cursor en flash (ms)
+#define PUSH_BUFFER_SIZE 1460         // Un lote cabe en un segmento TCP
+#define PUSH_HTTP_HEADER_ROOM 200     // Hueco para las cabeceras HTTP delante del cuerpo
+
+// Declaración de funciones externas (definidas en almacenamiento.h)
+extern void savePushCursor();
+
+enum PushState { PUSH_IDLE, PUSH_WAIT_ACK };
+
+// Estado del envío. Solo hay un lote en vuelo: los registros que llegan
+// mientras tanto se acumulan y forman el siguiente.
+WiFiClient pushClient;
+OutboundTarget pushTarget = {};
+PushState pushState = PUSH_IDLE;
+uint32_t pushBatchEnd = 0;            // Secuencia siguiente al último registro del lote en vuelo
+unsigned long pushSentAt = 0;
+unsigned long pushPendingSince = 0;   // Desde cuándo hay registros sin enviar (0 = ninguno)
+unsigned long pushRetryAt = 0;
+uint8_t pushFailureCount = 0;         // Fallos seguidos (para el backoff)
+bool pushCursorDirty = false;         // El cursor cambió desde la última escritura
+unsigned long pushCursorSavedAt = 0;
+uint8_t pushBuffer[PUSH_BUFFER_SIZE];
+char pushResponse[256];               // Confirmación recibida hasta ahora
+size_t pushResponseLen = 0;
+
+// ========= CONSTRUCCIÓN DE LOTES ===========
+
+// Trama Anviz como la respuesta a 0x40 (STX, CH, ACK 0xC0, RET, LEN,
+// número de registros y registros de 14 bytes) con la secuencia del primer
+// registro al final de DATA. El colector responde con 4 bytes: la secuencia
+// del siguiente registro que espera (big-endian).
+size_t buildPushFrame(uint32_t first, int count) {
+  uint16_t dataLen = 1 + count * 14 + 4;
+  pushBuffer[0] = STX;
+  pushBuffer[1] = (deviceId >> 24) & 0xFF;
+  pushBuffer[2] = (deviceId >> 16) & 0xFF;
+  pushBuffer[3] = (deviceId >> 8) & 0xFF;
+  pushBuffer[4] = deviceId & 0xFF;
+  pushBuffer[5] = 0xC0;
+  pushBuffer[6] = ACK_SUCCESS;
+  pushBuffer[7] = (dataLen >> 8) & 0xFF;
+  pushBuffer[8] = dataLen & 0xFF;
+  pushBuffer[9] = count;
+  copyWireRecords(&pushBuffer[10], first, count);
+  uint8_t* seqBytes = &pushBuffer[10 + count * 14];
+  seqBytes[0] = (first >> 24) & 0xFF;
+  seqBytes[1] = (first >> 16) & 0xFF;
+  seqBytes[2] = (first >> 8) & 0xFF;
+  seqBytes[3] = first & 0xFF;
+  uint16_t crc = calculateCRC16(pushBuffer, 9 + dataLen);
+  pushBuffer[9 + dataLen] = (crc >> 8) & 0xFF;
+  pushBuffer[9 + dataLen + 1] = crc & 0xFF;
+  return 9 + dataLen + 2;
+}
+
+// POST con un cuerpo JSON. El colector responde 2xx con {"ack":<siguiente
+// secuencia>}; un 2xx sin "ack" confirma el lote completo. Devuelve la
+// posición del inicio de la petición en pushBuffer y su longitud en len.
+size_t buildPushRequest(uint32_t first, int count, size_t& len) {
+  char* body = (char*)&pushBuffer[PUSH_HTTP_HEADER_ROOM];
+  size_t room = PUSH_BUFFER_SIZE - PUSH_HTTP_HEADER_ROOM;
+  size_t used = clampPrinted(snprintf_P(body, room, PSTR("{\"device\":%u,\"first\":%u,\"records\":["), deviceId, first), room);
+  for (int i = 0; i < count; i++) {
+    const AccessRecord& record = recordBySeq(first + i);
+    char idText[16];
+    formatUserId(idText, sizeof(idText), record.id);
+    used += clampPrinted(snprintf_P(&body[used], room - used,
+                                    PSTR("%s{\"seq\":%u,\"user\":\"%s\",\"ts\":%u,\"type\":%u,\"backup\":%u}"),
+                                    i > 0 ? "," : "", first + i, idText, recordTime(record) + 946684800UL,
+                                    record.recordType, record.backup), room - used);
+  }
+  used += clampPrinted(snprintf_P(&body[used], room - used, PSTR("]}")), room - used);
+
+  char header[PUSH_HTTP_HEADER_ROOM];
+  int headerLen = clampPrinted(snprintf_P(header, sizeof(header),
+                                          PSTR("POST %s HTTP/1.1\r\nHost: %s\r\nContent-Type: application/json\r\nContent-Length: %u\r\nConnection: keep-alive\r\n\r\n"),
+                                          pushConfig.path[0] ? pushConfig.path : "/", pushConfig.host, (unsigned)used), sizeof(header));
+  size_t start = PUSH_HTTP_HEADER_ROOM - headerLen;
+  memcpy(&pushBuffer[start], header, headerLen);
+  len = headerLen + used;
+  return start;
+}
+
+// Registros por lote en modo HTTP: cada uno ocupa como mucho ~90 bytes de JSON
+int pushBatchLimit() {
+  int limit = pushConfig.batchSize;
+  if (limit < 1) limit = 1;
+  if (limit > PUSH_MAX_BATCH) limit = PUSH_MAX_BATCH;
+  if (pushConfig.mode == PUSH_HTTP_JSON && limit > 12) limit = 12;
+  return limit;
+}
+
+// ========= CONFIRMACIONES Y REINTENTOS ===========
+
+// Fallo: cerrar la conexión y esperar el doble que la vez anterior
+void pushFail() {
+  pushClient.stop();
+  pushState = PUSH_IDLE;
+  metrics.pushFailures++;
+  if (pushFailureCount < 16) pushFailureCount++;
+  uint32_t delayMs = PUSH_BACKOFF_MIN << (pushFailureCount - 1 < 6 ? pushFailureCount - 1 : 6);
+  if (delayMs > PUSH_BACKOFF_MAX) delayMs = PUSH_BACKOFF_MAX;
+  pushRetryAt = millis() + delayMs;
+}
+
+// Aplicar una confirmación: solo vale si avanza dentro del lote enviado
+void pushAcknowledge(uint32_t ack) {
+  if (ack <= pushCursor || ack > pushBatchEnd) {
+    pushFail();
+    return;
+  }
+  metrics.pushBatches++;
+  metrics.pushRecords += ack - pushCursor;
+  pushCursor = ack;
+  pushCursorDirty = true;
+  pushFailureCount = 0;
+  pushState = PUSH_IDLE;
+}
+
+// Interpretar la respuesta HTTP acumulada. Devuelve false si aún está incompleta.
+bool parsePushHttpResponse() {
+  char* bodyStart = strstr(pushResponse, "\r\n\r\n");
+  if (bodyStart == nullptr) return false;
+  bodyStart += 4;
+
+  const char* lengthHeader = strstr(pushResponse, "Content-Length:");
+  if (lengthHeader != nullptr && lengthHeader < bodyStart) {
+    size_t expected = strtoul(lengthHeader + 15, nullptr, 10);
+    size_t received = pushResponseLen - (bodyStart - pushResponse);
+    if (received < expected && pushResponseLen < sizeof(pushResponse) - 1) return false;
+  }
+
+  int status = (strncmp(pushResponse, "HTTP/1.", 7) == 0) ? atoi(&pushResponse[9]) : 0;
+  if (status < 200 || status >= 300) {
+    pushFail();
+    return true;
+  }
+  const char* ackField = strstr(bodyStart, "\"ack\":");
+  pushAcknowledge(ackField != nullptr ? strtoul(ackField + 6, nullptr, 10) : pushBatchEnd);
+  return true;
+}
+
+// Leer lo que haya llegado de la confirmación sin bloquear
+void pumpPushAck() {
+  while (pushClient.available() > 0 && pushResponseLen < sizeof(pushResponse) - 1) {
+    pushResponse[pushResponseLen++] = pushClient.read();
+  }
+  pushResponse[pushResponseLen] = 0;
+
+  if (pushConfig.mode == PUSH_TCP_ANVIZ) {
+    if (pushResponseLen >= 4) {
+      const uint8_t* b = (const uint8_t*)pushResponse;
+      pushAcknowledge(((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3]);
+      return;
+    }
+  } else if (parsePushHttpResponse()) {
+    return;
+  }
+
+  if (!pushClient.connected() || millis() - pushSentAt > PUSH_ACK_TIMEOUT) {
+    pushFail();
+  }
+}
+
+// ========= BUCLE DE ENVÍO ===========
+
+// Llamar en cada iteración del loop. Solo la conexión bloquea: la primera
+// resolución del host (OUTBOUND_DNS_TIMEOUT) y cada intento de conexión
+// (PUSH_CONNECT_TIMEOUT), espaciados por el backoff. El resto no espera.
+void pumpPush() {
+  if (!pushConfig.enabled || pushConfig.host[0] == 0 || WiFi.status() != WL_CONNECTED) return;
+
+  // El cursor no puede apuntar fuera del almacén: registros sobrescritos sin
+  // confirmar, o registros borrados o perdidos al reiniciar
+  if (pushCursor < firstRecordSeq()) {
+    metrics.pushSkipped += firstRecordSeq() - pushCursor;
+    pushCursor = firstRecordSeq();
+    pushCursorDirty = true;
+  } else if (pushCursor > (uint32_t)recordCount) {
+    pushCursor = recordCount;
+    pushCursorDirty = true;
+  }
+
+  if (pushCursorDirty && millis() - pushCursorSavedAt > PUSH_CURSOR_SAVE_INTERVAL) {
+    savePushCursor();
+  }
+
+  if (pushState == PUSH_WAIT_ACK) {
+    pumpPushAck();
+    return;
+  }
+
+  uint32_t pending = recordCount - pushCursor;
+  if (pending == 0) {
+    pushPendingSince = 0;
+    return;
+  }
+  if (pushPendingSince == 0) pushPendingSince = millis() | 1;
+
+  int limit = pushBatchLimit();
+  if (pending < (uint32_t)limit && millis() - pushPendingSince < PUSH_LINGER) return;
+  if ((long)(millis() - pushRetryAt) < 0) return;
+
+  if (!pushClient.connected() &&
+      !connectOutbound(pushClient, pushTarget, pushConfig.host, pushConfig.port, PUSH_CONNECT_TIMEOUT)) {
+    pushFail();
+    return;
+  }
+
+  int count = (pending < (uint32_t)limit) ? pending : limit;
+  size_t start = 0;
+  size_t len;
+  if (pushConfig.mode == PUSH_TCP_ANVIZ) {
+    len = buildPushFrame(pushCursor, count);
+  } else {
+    start = buildPushRequest(pushCursor, count, len);
+  }
+
+  // Sin hueco en el búfer TCP: se reintenta en la próxima pasada
+  if ((size_t)pushClient.availableForWrite() < len) return;
+
+  while (pushClient.available() > 0) pushClient.read();  // Restos de una respuesta anterior
+  pushClient.write(&pushBuffer[start], len);
+  pushBatchEnd = pushCursor + count;
+  pushState = PUSH_WAIT_ACK;
+  pushSentAt = millis();
+  pushPendingSince = 0;
+  pushResponseLen = 0;
+}
+
+#endif // ENVIO_H
@@ -18,17 +18,52 @@ typedef struct {
   uint8_t fpStatus[2];  // Estado de huella digital (no utilizada)
   uint8_t special;      // Información especial
   bool isActive;        // Estado activo/inactivo
+  uint32_t version;     // Versión del último cambio (diario de cambios)
 } User;
 
-// Estructura de registros de acceso
+// Estructura de registros de acceso, con la misma disposición de 14 bytes
+// que un registro en la trama de 0x40/0x41: una página de registros es una
+// copia directa desde el almacén. Solo bytes, así que no hay relleno.
+// La hora se lee y escribe con recordTime()/setRecordTime() (registros.h).
 typedef struct {
   uint8_t id[5];        // ID de usuario
-  uint32_t timestamp;   // Tiempo (segundos desde 2000-01-01)
+  uint8_t time[4];      // Tiempo en la trama (big-endian, segundos desde 2000-01-01 con la corrección de un día)
   uint8_t backup;       // Código de backup (tipo de verificación)
   uint8_t recordType;   // Tipo de registro
   uint8_t workCode[3];  // Código de trabajo (no utilizado)
 } AccessRecord;
 
+static_assert(sizeof(AccessRecord) == 14, "AccessRecord debe coincidir con el registro de la trama");
+
+// ========= LECTORES WIEGAND ===========
+#define MAX_READERS 4         // Lectores Wiegand admitidos
+#define WIEGAND_QUEUE_SIZE 4  // Tarjetas leídas pendientes de decidir por lector
+#define READER_PIN_UNUSED 0xFF
+
+// Pines y sentido de un lector
+typedef struct {
+  uint8_t pin_d0;           // Pin para Wiegand D0
+  uint8_t pin_d1;           // Pin para Wiegand D1
+  uint8_t direction;        // 0 = entrada, 1 = salida (bits bajos del tipo de registro)
+} ReaderConfig;
+
+// Trama Wiegand completa, pendiente de decodificar
+typedef struct {
+  uint64_t data;                    // El primer bit recibido queda en la posición bits - 1
+  uint8_t bits;
+} WiegandFrame;
+
+// Estado de un lector: lo que escribe su ISR y la cola de tramas completas
+typedef struct {
+  volatile uint64_t data;           // Bits recibidos de la trama en curso
+  volatile uint8_t bitCount;        // Número de bits recibidos
+  volatile unsigned long lastBit;   // millis() del último bit (fin de trama por timeout)
+  WiegandFrame queue[WIEGAND_QUEUE_SIZE];
+  uint8_t head;                     // Próxima trama a decidir
+  uint8_t count;                    // Tramas en cola
+  uint32_t overruns;                // Tramas descartadas por cola llena
+} WiegandReader;
+
 // Configuración básica del dispositivo
 typedef struct {
   char firmwareVersion[9];  // Versión firmware (8 char + null)
@@ -40,16 +75,244 @@ typedef struct {
   uint8_t machineStatus;    // Estado de la máquina
   uint8_t languageFlag;     // Banderas de idioma
   uint8_t cmdVersion;       // Versión de comandos
-  uint8_t pin_d0;           // Pin para Wiegand D0
-  uint8_t pin_d1;           // Pin para Wiegand D1
+  ReaderConfig readers[MAX_READERS]; // Lectores Wiegand
+  uint8_t readerCount;      // Lectores configurados (al menos 1)
   uint8_t pin_relay;        // Pin para el relé
   uint8_t pin_led;          // Pin para el LED de estado
   bool rebootEnabled;       // Habilitar reinicio automático
   uint8_t rebootHour;       // Hora para el reinicio automático
   uint8_t rebootMinute;     // Minuto para el reinicio automático
   uint16_t relayOnDuration; // Tiempo de activación del relé en ms
+  uint16_t duplicateWindow; // Ventana para descartar lecturas repetidas en ms (0 = desactivado)
+  uint16_t antiPassbackTime;// Anti-passback: segundos sin repetir sentido (0 = desactivado)
+  uint16_t sessionIdleTimeout; // Cerrar la sesión TCP tras estos segundos sin comandos (0 = nunca)
+  uint16_t keepAliveIdle;   // Keepalive TCP: segundos sin tráfico antes de sondear (0 = desactivado)
+  uint8_t bulkPages;        // Máximo de tramas por petición masiva de 0x40/0x42 (extensión propia)
 } BasicConfig;
 
+// ========= PERFILADO DE MEMORIA ===========
+// Operaciones a las que se atribuyen las mediciones de heap y pila
+enum MemOperation { MEM_OP_LOOP, MEM_OP_SYNC, MEM_OP_SAVE, MEM_OP_WEB, MEM_OP_COUNT };
+
+// Marcas de agua (peor valor observado) para una operación
+typedef struct {
+  uint32_t minFreeHeap;     // Mínimo de heap libre (bytes)
+  uint32_t minMaxBlock;     // Mínimo del bloque libre más grande (bytes)
+  uint8_t maxFragmentation; // Máxima fragmentación del heap (%)
+  uint32_t minFreeStack;    // Mínimo de pila libre (bytes)
+  uint32_t samples;         // Número de muestras tomadas
+} MemProfile;
+
+// ========= MÉTRICAS ===========
+#define LOOP_HISTOGRAM_BUCKETS 12     // Cubetas del histograma de duración del loop
+#define SESSION_LIFETIME_BUCKETS 6    // Cubetas del histograma de duración de las sesiones TCP
+
+// Motivo del cierre de una sesión TCP con CrossChex
+enum SessionCloseReason { SESSION_CLOSE_PEER, SESSION_CLOSE_IDLE, SESSION_CLOSE_REPLACED, SESSION_CLOSE_STALLED, SESSION_CLOSE_COUNT };
+
+// Contadores expuestos en /metrics (todos monótonos salvo indicación)
+typedef struct {
+  uint32_t accessGranted;           // Accesos concedidos
+  uint32_t accessDenied;            // Accesos denegados
+  uint32_t frameCrcErrors;          // Tramas Anviz con CRC incorrecto
+  uint32_t frameIncomplete;         // Tramas Anviz incompletas (timeout)
+  uint32_t frameStxErrors;          // Tramas Anviz con STX incorrecto
+  uint32_t commandCounts[128];      // Comandos Anviz válidos por código de operación
+  uint32_t flashBytesRecords;       // Bytes escritos por saveRecords()
+  uint32_t flashBytesUsers;         // Bytes escritos por saveUsers()
+  uint32_t flashBytesAttendance;    // Bytes escritos por saveAttendance()
+  uint32_t wifiReconnects;          // Reconexiones WiFi
+  uint32_t swipesSuppressed;        // Lecturas repetidas descartadas
+  uint32_t accessThrottled;         // Tarjetas desconocidas descartadas por el limitador
+  uint32_t negativeCacheHits;       // Tarjetas desconocidas resueltas sin buscar
+  uint32_t wiegandParityErrors;     // Tramas con paridad incorrecta
+  uint32_t wiegandUnknownFormats;   // Tramas de longitud no soportada
+  uint32_t wiegandWideIds;          // Tarjetas rechazadas por no caber en 32 bits
+  uint32_t scheduleUnsynced;        // Horarios decididos sin hora válida en el reloj
+  uint32_t pushBatches;             // Lotes confirmados por el colector
+  uint32_t pushRecords;             // Registros confirmados por el colector
+  uint32_t pushFailures;            // Envíos fallidos (conexión, tiempo o confirmación)
+  uint32_t pushSkipped;             // Registros sobrescritos antes de enviarse
+  uint32_t mqttPublished;           // Eventos publicados en el broker
+  uint32_t mqttQueued;              // Eventos guardados en flash sin conexión
+  uint32_t mqttDropped;             // Eventos descartados con la cola de RAM o de flash llena
+  uint32_t mqttReconnects;          // Conexiones al broker
+  uint32_t txDeferred;              // Respuestas TCP que no cupieron enteras en el búfer del socket
+  uint32_t txBackpressure;          // Pasadas del loop con un comando esperando hueco en la cola
+  uint32_t txOverflows;             // Respuestas TCP descartadas por cola llena
+  uint32_t sessionsOpened;          // Sesiones TCP aceptadas
+  uint32_t sessionsRejected;        // Conexiones rechazadas por haber otra sesión viva
+  uint32_t sessionCloses[SESSION_CLOSE_COUNT]; // Sesiones cerradas por motivo
+  uint32_t sessionLifetimeHistogram[SESSION_LIFETIME_BUCKETS + 1]; // Duración de las sesiones (última = +Inf)
+  uint32_t sessionLifetimeTotal;    // Suma de duraciones de las sesiones (s)
+  uint32_t loopHistogram[LOOP_HISTOGRAM_BUCKETS + 1]; // Duración del loop (última = +Inf)
+  uint64_t loopTotalMicros;         // Suma de duraciones del loop (µs)
+  uint32_t loopCount;               // Iteraciones del loop medidas
+} Metrics;
+
+// ========= EVENTOS DE ACCESO ===========
+enum AccessEventKind { EVENT_GRANTED, EVENT_DENIED, EVENT_DENIED_SCHEDULE, EVENT_DENIED_PASSBACK, EVENT_FORCED_UNLOCK };
+
+// Evento compacto emitido en cada decisión de acceso
+typedef struct {
+  uint32_t seq;         // Secuencia del registro creado (solo en accesos concedidos)
+  uint32_t timestamp;   // Tiempo (segundos desde 2000-01-01)
+  uint32_t cardId;      // Tarjeta leída
+  uint8_t id[5];        // ID de usuario (ceros si es desconocido)
+  uint8_t kind;         // AccessEventKind
+  uint8_t recordType;   // Tipo de registro (dirección)
+} AccessEvent;
+
+// ========= CONSULTAS DE REGISTROS ===========
+#define RECORD_BLOCK_SIZE 25  // Registros por bloque del índice temporal (una página de 0x40)
+
+// Resumen de un bloque de registros consecutivos: permite descartar el
+// bloque entero sin leer ninguno de sus registros
+typedef struct {
+  uint32_t block;         // Número de bloque (secuencia / RECORD_BLOCK_SIZE)
+  uint32_t minTime;       // Tiempo mínimo del bloque (segundos desde 2000-01-01)
+  uint32_t maxTime;       // Tiempo máximo del bloque
+  uint32_t userBloom[2];  // Filtro de Bloom de 64 bits con los IDs de usuario
+} RecordBlockSummary;
+
+// Consulta en curso sobre el almacén de registros (ver registros.h)
+typedef struct {
+  uint32_t cursor;        // Próxima secuencia a examinar
+  uint32_t end;           // Secuencia final (exclusiva)
+  uint32_t from;          // Tiempo inicial, inclusivo (segundos desde 2000-01-01)
+  uint32_t to;            // Tiempo final, inclusivo
+  uint8_t userId[5];      // Usuario buscado si filterUser
+  bool filterUser;
+} RecordQuery;
+
+// ========= ASISTENCIA DIARIA ===========
+// Resumen de un usuario en un día: se actualiza con cada registro añadido
+typedef struct {
+  uint32_t firstIn;     // Primer registro del día (segundos desde 2000-01-01)
+  uint32_t lastOut;     // Último registro del día
+  uint8_t id[5];        // ID de usuario
+  uint8_t reserved;
+  uint16_t count;       // Registros del usuario ese día
+} DailyAttendance;
+
+// ========= HORARIOS DE ACCESO ===========
+#define SCHEDULE_DAY_HOLIDAY 7  // Tipo de día "festivo" (0-6 = domingo-sábado)
+
+// Franja horaria permitida para un grupo. Las reglas se compilan en mapas
+// de bits (ver horarios.h); no se evalúan al leer una tarjeta.
+typedef struct {
+  uint8_t group;        // Grupo de usuario al que se aplica
+  uint8_t days;         // Bit n = tipo de día n (bit 7 = festivos)
+  uint8_t startSlot;    // Primera franja de 15 minutos (0-95)
+  uint8_t endSlot;      // Franja final, exclusiva (1-96)
+} ScheduleRule;
+
+// ========= LECTURAS RECIENTES ===========
+// Última lectura de una tarjeta, para descartar repeticiones
+typedef struct {
+  uint32_t cardId;
+  uint32_t lastSeen;    // millis() de la última lectura (concedida o no)
+  bool used;
+} SwipeEntry;
+
+// Último acceso concedido a una tarjeta, para el anti-passback
+typedef struct {
+  uint32_t cardId;
+  uint32_t lastGrant;   // millis() del acceso
+  uint8_t direction;    // Sentido del acceso (tipo de registro)
+  bool used;
+} PassbackEntry;
+
+// ========= DENEGACIONES ===========
+enum DenyReason { DENY_UNKNOWN, DENY_SCHEDULE, DENY_PASSBACK, DENY_THROTTLED };
+
+// Entrada del registro de denegaciones (fuera del almacén de registros).
+// Los intentos seguidos de la misma tarjeta y motivo se agrupan en una sola.
+typedef struct {
+  uint32_t timestamp;   // Último intento (segundos desde 2000-01-01)
+  uint32_t cardId;
+  uint16_t attempts;    // Intentos agrupados
+  uint8_t reason;       // DenyReason
+  uint8_t reader;       // Lector
+} DenialEntry;
+
+// Limitador de intentos denegados por lector (cubo de fichas)
+typedef struct {
+  uint8_t tokens;
+  uint32_t lastRefill;  // millis() de la última ficha repuesta
+} RateLimiter;
+
+// ========= CURSORES DE DESCARGA ===========
+#define MAX_DOWNLOAD_CLIENTS 4        // Clientes (por IP) con cursor de descarga propio
+
+// Posición de un cliente en la descarga de registros (0x40), por secuencia
+typedef struct {
+  uint32_t ip;          // Dirección del cliente (0 = libre)
+  uint32_t sent;        // Secuencia siguiente al último registro enviado
+  uint32_t acked;       // Secuencia siguiente al último registro confirmado
+  uint32_t lastUsed;    // Orden de uso, para sustituir el menos reciente
+} DownloadCursor;
+
+// ========= DIARIO DE CAMBIOS DE USUARIOS ===========
+#define USER_JOURNAL_SIZE 128         // Cambios recordados para la sincronización incremental
+
+enum UserChangeOp { USER_CHANGE_ADD, USER_CHANGE_UPDATE, USER_CHANGE_DELETE };
+
+// Entrada del diario: qué usuario cambió y con qué versión
+typedef struct {
+  uint32_t version;
+  uint8_t id[5];
+  uint8_t op;           // UserChangeOp
+} UserChange;
+
+// ========= RANGOS DE TARJETAS ===========
+#define MAX_CARD_RANGES 8             // Rangos de tarjetas (visitantes, contratas...)
+#define MAX_RANGE_CARDS 65536         // Tarjetas por rango: 8 KB de mapa de bits
+#define CARD_RANGE_ID_MARK 0xFF       // Primer byte del ID de los accesos por rango (IDs reservados)
+
+// Rango de tarjetas consecutivas. El mapa de bits (un bit por tarjeta) vive en
+// /range<file>.bin; aquí solo se guarda la cabecera.
+typedef struct {
+  uint32_t firstCard;   // Primera tarjeta del rango
+  uint32_t count;       // Tarjetas del rango
+  uint32_t enabled;     // Tarjetas habilitadas (bits a 1)
+  uint8_t group;        // Grupo de horario que se aplica
+  uint8_t file;         // Número de archivo del mapa de bits
+  char label[11];       // Descripción (como el nombre de usuario)
+} CardRange;
+
+// ========= ENVÍO A COLECTOR ===========
+enum PushMode { PUSH_TCP_ANVIZ, PUSH_HTTP_JSON };
+
+// Destino al que se envían los registros nuevos sin esperar a CrossChex
+typedef struct {
+  bool enabled;
+  uint8_t mode;         // PushMode
+  char host[40];
+  uint16_t port;
+  char path[40];        // Ruta del POST en modo HTTP
+  uint8_t batchSize;    // Registros por lote (1-25)
+} PushConfig;
+
+// Destino de una conexión saliente con su dirección ya resuelta (utilidades.h)
+typedef struct {
+  char host[40];        // Host para el que vale address
+  IPAddress address;
+  bool resolved;
+  uint8_t failures;     // Conexiones fallidas seguidas
+} OutboundTarget;
+
+// ========= MQTT ===========
+// Broker al que se publican los eventos y del que se reciben órdenes
+typedef struct {
+  bool enabled;
+  char host[40];
+  uint16_t port;
+  char user[33];
+  char pass[33];
+  char prefix[32];      // Prefijo de los topics (p. ej. "anviz/puerta1")
+} MqttConfig;
+
 // ========= MANEJO NO BLOQUEANTE ===========
 enum LedState { LED_IDLE, LED_ACCESS_GRANTED, LED_ACCESS_DENIED, LED_FORCED_UNLOCK };
 
@@ -0,0 +1,163 @@
+/**
+ * eventos.h
+ * Canal de eventos de acceso en vivo mediante Server-Sent Events (/events)
+ */
+
+#ifndef EVENTOS_H
+#define EVENTOS_H
+
+#define MAX_EVENT_SUBSCRIBERS 3       // Navegadores suscritos simultáneamente
+#define EVENT_QUEUE_SIZE 8            // Eventos pendientes por suscriptor
+#define EVENT_PING_INTERVAL 15000     // Comentario keep-alive para detectar desconexiones (ms)
+
+// Estado de cada suscriptor. La cola es acotada y descarta el evento más
+// antiguo cuando se llena, así un navegador lento nunca frena el loop.
+typedef struct {
+  WiFiClient client;
+  bool active;
+  AccessEvent queue[EVENT_QUEUE_SIZE];
+  uint8_t head;                  // Próximo evento a enviar
+  uint8_t count;                 // Eventos en cola
+  uint32_t dropped;              // Eventos descartados por cola llena
+  char pending[200];             // Evento ya formateado, enviado parcialmente
+  uint16_t pendingLen;
+  uint16_t pendingOffset;
+  unsigned long lastWrite;
+} EventSubscriber;
+
+EventSubscriber eventSubscribers[MAX_EVENT_SUBSCRIBERS];
+
+// Declaración de funciones externas (definidas en mqtt.h)
+extern void mqttQueueEvent(const AccessEvent& event);
+
+// ========= PRODUCCIÓN DE EVENTOS ===========
+
+// Encolar un evento para todos los suscriptores y para MQTT (sin E/S de red)
+void emitAccessEvent(const AccessEvent& event) {
+  mqttQueueEvent(event);
+
+  for (int i = 0; i < MAX_EVENT_SUBSCRIBERS; i++) {
+    EventSubscriber& s = eventSubscribers[i];
+    if (!s.active) continue;
+    if (s.count == EVENT_QUEUE_SIZE) {
+      // Cola llena: descartar el más antiguo
+      s.head = (s.head + 1) % EVENT_QUEUE_SIZE;
+      s.count--;
+      s.dropped++;
+    }
+    s.queue[(s.head + s.count) % EVENT_QUEUE_SIZE] = event;
+    s.count++;
+  }
+}
+
+// Nombre del tipo de evento en el campo "r"
+const char* accessEventKindName(uint8_t kind) {
+  switch (kind) {
+    case EVENT_GRANTED: return "grant";
+    case EVENT_DENIED_SCHEDULE: return "schedule";
+    case EVENT_DENIED_PASSBACK: return "passback";
+    case EVENT_FORCED_UNLOCK: return "unlock";
+    default: return "deny";
+  }
+}
+
+// Formatear un evento como mensaje SSE
+uint16_t formatAccessEvent(char* buffer, size_t len, const AccessEvent& event, uint32_t dropped) {
+  char idText[16] = "";
+  char nameText[64] = "";
+  if (event.kind != EVENT_DENIED && event.kind != EVENT_FORCED_UNLOCK) {
+    formatUserId(idText, sizeof(idText), event.id);
+    int userIndex = indexFindUserById(event.id);
+    if (userIndex >= 0) {
+      jsonEscapeName(nameText, sizeof(nameText), users[userIndex].name);
+    }
+  }
+  int n = snprintf_P(buffer, len,
+                     PSTR("event: access\ndata: {\"r\":\"%s\",\"seq\":%u,\"ts\":%u,\"card\":%u,\"user\":\"%s\",\"name\":\"%s\",\"type\":%u,\"dropped\":%u}\n\n"),
+                     accessEventKindName(event.kind), event.seq,
+                     event.timestamp + 946684800UL, event.cardId, idText, nameText,
+                     event.recordType, dropped);
+  return (n < 0) ? 0 : ((size_t)n >= len ? len - 1 : n);
+}
+
+// ========= ENVÍO NO BLOQUEANTE ===========
+
+// Liberar la ranura de un suscriptor
+void closeEventSubscriber(EventSubscriber& s) {
+  s.client.stop();
+  s.client = WiFiClient();
+  s.active = false;
+  s.count = 0;
+  s.pendingLen = 0;
+}
+
+// Avanzar el envío de cada suscriptor sin bloquear: solo se escribe lo que
+// cabe en el búfer TCP en este momento y el resto queda para la próxima pasada.
+void pumpEventSubscribers() {
+  for (int i = 0; i < MAX_EVENT_SUBSCRIBERS; i++) {
+    EventSubscriber& s = eventSubscribers[i];
+    if (!s.active) continue;
+    if (!s.client.connected()) {
+      closeEventSubscriber(s);
+      continue;
+    }
+
+    if (s.pendingOffset >= s.pendingLen) {
+      s.pendingLen = 0;
+      s.pendingOffset = 0;
+      if (s.count > 0) {
+        s.pendingLen = formatAccessEvent(s.pending, sizeof(s.pending), s.queue[s.head], s.dropped);
+        s.head = (s.head + 1) % EVENT_QUEUE_SIZE;
+        s.count--;
+      } else if (millis() - s.lastWrite > EVENT_PING_INTERVAL) {
+        s.pendingLen = snprintf_P(s.pending, sizeof(s.pending), PSTR(": ping\n\n"));
+      }
+    }
+
+    if (s.pendingLen > s.pendingOffset) {
+      size_t room = s.client.availableForWrite();
+      size_t remaining = s.pendingLen - s.pendingOffset;
+      if (room == 0) continue;
+      size_t written = s.client.write((const uint8_t*)&s.pending[s.pendingOffset], remaining < room ? remaining : room);
+      s.pendingOffset += written;
+      s.lastWrite = millis();
+    }
+  }
+}
+
+// ========= ENDPOINT ===========
+
+// GET /events: toma la conexión del servidor web y la mantiene abierta como
+// flujo text/event-stream que se alimenta desde pumpEventSubscribers()
+void handleEvents() {
+  if (!isAuthenticated()) return;
+
+  int slot = -1;
+  for (int i = 0; i < MAX_EVENT_SUBSCRIBERS; i++) {
+    if (eventSubscribers[i].active && !eventSubscribers[i].client.connected()) {
+      closeEventSubscriber(eventSubscribers[i]);
+    }
+    if (!eventSubscribers[i].active && slot < 0) {
+      slot = i;
+    }
+  }
+  if (slot < 0) {
+    webServer.send(503, "text/plain", "Demasiados suscriptores");
+    return;
+  }
+
+  EventSubscriber& s = eventSubscribers[slot];
+  s.client = webServer.client();
+  s.client.setNoDelay(true);
+  s.client.print(F("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\nConnection: keep-alive\r\n\r\nretry: 3000\n\n"));
+  s.active = true;
+  s.head = 0;
+  s.count = 0;
+  s.dropped = 0;
+  s.pendingLen = 0;
+  s.pendingOffset = 0;
+  s.lastWrite = millis();
+  Serial.println("[EVENTOS] Nuevo suscriptor SSE");
+}
+
+#endif // EVENTOS_H
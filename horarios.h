@@ -0,0 +1,123 @@
+/**
+ * horarios.h
+ * Horarios de acceso por grupo (día de la semana o festivo y franjas de
+ * 15 minutos), compilados en mapas de bits
+ */
+
+#ifndef HORARIOS_H
+#define HORARIOS_H
+
+#define SCHEDULE_GROUPS 8           // Grupos con horario (0-7); el resto no tiene restricción
+#define SCHEDULE_SLOTS 96           // Franjas de 15 minutos por día
+#define MAX_SCHEDULE_RULES 32
+#define MAX_HOLIDAYS 32
+#define CLOCK_MIN_VALID_TIME 1577836800UL  // 2020-01-01: antes de esto el reloj no está en hora
+#define SCHEDULE_ALLOW_UNSYNCED false      // Sin hora válida, ¿se deja pasar a los grupos con horario?
+
+// Reglas tal como se configuran y guardan en /schedule.json
+ScheduleRule scheduleRules[MAX_SCHEDULE_RULES];
+int scheduleRuleCount = 0;
+uint16_t holidays[MAX_HOLIDAYS];    // Días festivos (días desde 2000-01-01)
+int holidayCount = 0;
+
+// Forma compilada: un bit por grupo, tipo de día y franja. Un grupo sin
+// ninguna regla no tiene restricción horaria (comportamiento anterior).
+uint8_t scheduleBitmap[SCHEDULE_GROUPS][8][SCHEDULE_SLOTS / 8];
+uint8_t restrictedGroups = 0;       // Bit g = el grupo g tiene reglas
+
+// El tipo del día actual se calcula una vez por día
+uint16_t cachedScheduleDay = UINT16_MAX;
+uint8_t cachedScheduleDayKind = 0;
+
+// Declaración de variables externas (definidas en metricas.h)
+extern Metrics metrics;
+
+// ========= FECHAS ===========
+
+// Convertir "YYYY-MM-DD" a días desde 2000-01-01
+bool parseDayText(const char* text, uint16_t& day) {
+  int year, month, dayOfMonth;
+  if (sscanf(text, "%d-%d-%d", &year, &month, &dayOfMonth) != 3 ||
+      year < 2000 || year > 2150 || month < 1 || month > 12 || dayOfMonth < 1 || dayOfMonth > 31) {
+    return false;
+  }
+  tmElements_t tm = {0};
+  tm.Year = CalendarYrToTm(year);
+  tm.Month = month;
+  tm.Day = dayOfMonth;
+  day = (makeTime(tm) - 946684800UL) / 86400UL;
+  return true;
+}
+
+// Escribir un día desde 2000-01-01 como "YYYY-MM-DD"
+void formatDayText(char* buffer, size_t len, uint16_t day) {
+  tmElements_t tm;
+  breakTime((time_t)day * 86400UL + 946684800UL, tm);
+  snprintf_P(buffer, len, PSTR("%04d-%02d-%02d"), tmYearToCalendar(tm.Year), tm.Month, tm.Day);
+}
+
+// ========= COMPILACIÓN ===========
+
+// Regenerar los mapas de bits. Llamar tras cualquier cambio en las reglas
+// o en los festivos.
+void compileSchedules() {
+  memset(scheduleBitmap, 0, sizeof(scheduleBitmap));
+  restrictedGroups = 0;
+
+  for (int i = 0; i < scheduleRuleCount; i++) {
+    const ScheduleRule& rule = scheduleRules[i];
+    if (rule.group >= SCHEDULE_GROUPS) continue;
+    restrictedGroups |= 1 << rule.group;
+    for (int kind = 0; kind < 8; kind++) {
+      if (!(rule.days & (1 << kind))) continue;
+      for (int slot = rule.startSlot; slot < rule.endSlot && slot < SCHEDULE_SLOTS; slot++) {
+        scheduleBitmap[rule.group][kind][slot >> 3] |= 1 << (slot & 7);
+      }
+    }
+  }
+
+  cachedScheduleDay = UINT16_MAX;
+}
+
+// Tipo de día: festivo (SCHEDULE_DAY_HOLIDAY) o día de la semana (0 = domingo)
+uint8_t scheduleDayKind(uint16_t day) {
+  if (day != cachedScheduleDay) {
+    cachedScheduleDay = day;
+    cachedScheduleDayKind = (day + 6) % 7;  // 2000-01-01 fue sábado
+    for (int i = 0; i < holidayCount; i++) {
+      if (holidays[i] == day) {
+        cachedScheduleDayKind = SCHEDULE_DAY_HOLIDAY;
+        break;
+      }
+    }
+  }
+  return cachedScheduleDayKind;
+}
+
+// ========= DECISIÓN ===========
+
+// ¿Tiene el reloj una hora real? Tras arrancar sin NTP ni hora enviada por
+// el software (comando 0x38) el reloj cuenta desde 1970.
+bool clockIsValid() {
+  return timeStatus() != timeNotSet && now() >= CLOCK_MIN_VALID_TIME;
+}
+
+// ¿Puede un usuario del grupo acceder en este momento? (tiempo local en
+// segundos desde 2000-01-01). Es una única comprobación de bit.
+// Sin hora válida no se puede saber la franja: los grupos con horario se
+// deciden con SCHEDULE_ALLOW_UNSYNCED (por defecto se deniegan) y se avisa.
+// Los grupos sin reglas no dependen del reloj.
+bool scheduleAllows(uint8_t group, uint32_t timestamp) {
+  if (group >= SCHEDULE_GROUPS || !(restrictedGroups & (1 << group))) return true;
+  if (!clockIsValid()) {
+    metrics.scheduleUnsynced++;
+    Serial.println(SCHEDULE_ALLOW_UNSYNCED ? "[HORARIO] Reloj sin hora valida: se permite el acceso"
+                                           : "[HORARIO] Reloj sin hora valida: se deniega el acceso");
+    return SCHEDULE_ALLOW_UNSYNCED;
+  }
+  uint8_t kind = scheduleDayKind(timestamp / 86400UL);
+  uint8_t slot = (timestamp % 86400UL) / 900;
+  return scheduleBitmap[group][kind][slot >> 3] & (1 << (slot & 7));
+}
+
+#endif // HORARIOS_H
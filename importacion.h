@@ -0,0 +1,401 @@
+/**
+ * importacion.h
+ * Importación de usuarios desde archivos CSV o JSON subidos por la web,
+ * procesados por partes a medida que llegan, sin archivo intermedio
+ */
+
+#ifndef IMPORTACION_H
+#define IMPORTACION_H
+
+#define IMPORT_LINE_MAX 160           // Línea CSV u objeto JSON más largo admitido
+#define IMPORT_MAX_COLUMNS 12         // Columnas CSV que se examinan
+
+// Declaración de funciones externas (definidas en utilidades.h y almacenamiento.h)
+extern bool parseUserId(const char* text, uint8_t* id);
+extern void saveUsers();
+
+// Columnas reconocidas en la cabecera CSV (o en las claves JSON)
+enum ImportField { IMPORT_SKIP, IMPORT_ID, IMPORT_NAME, IMPORT_CARD, IMPORT_DEPT, IMPORT_GROUP, IMPORT_ACTIVE };
+
+// Fila ya separada en campos; los campos vacíos conservan el valor actual
+// del usuario (o el valor por defecto en un alta)
+typedef struct {
+  uint8_t id[5];
+  const char* name;
+  const char* card;
+  const char* dept;
+  const char* group;
+  const char* active;
+} ImportRow;
+
+// Estado de la importación en curso. Solo se guarda la línea (u objeto)
+// incompleta entre dos trozos de la subida, así que la memoria no depende
+// del tamaño del archivo.
+typedef struct {
+  bool active;
+  bool json;                  // Formato decidido por el primer carácter útil
+  bool formatKnown;
+  bool headerChecked;         // Ya se ha visto la primera línea CSV
+  uint8_t columns[IMPORT_MAX_COLUMNS];
+  uint8_t columnCount;
+  char separator;             // ',' o ';' (exportaciones de Excel en español)
+  char line[IMPORT_LINE_MAX];
+  uint16_t lineLen;
+  bool overflow;              // Línea demasiado larga: se descarta hasta el final
+  bool capturing;             // JSON: dentro de un objeto de usuario
+  bool inString;
+  bool escape;
+  uint32_t rows;
+  uint32_t added;
+  uint32_t updated;
+  uint32_t unchanged;
+  uint32_t rejected;          // ID, tarjeta, departamento o grupo no válidos, tarjeta de otro usuario o línea demasiado larga
+  uint32_t full;              // Altas sin hueco en la tabla
+} UserImport;
+
+UserImport userImport;
+
+// ========= APLICACIÓN DE FILAS ===========
+
+// Valor numérico de un campo; false si está vacío o no es un número
+bool importNumber(const char* text, uint32_t& value) {
+  if (text == nullptr || *text == 0) return false;
+  uint64_t result = 0;
+  for (; *text; text++) {
+    if (*text < '0' || *text > '9') return false;
+    result = result * 10 + (*text - '0');
+    if (result > 0xFFFFFFFFULL) return false;
+  }
+  value = result;
+  return true;
+}
+
+// Departamento o grupo: vacío no cambia nada; si viene, debe caber en un byte
+bool importByte(const char* text, uint8_t& target) {
+  if (text == nullptr || *text == 0) return true;
+  uint32_t value;
+  if (!importNumber(text, value) || value > 255) return false;
+  target = value;
+  return true;
+}
+
+// Alta o actualización de un usuario. Busca por los índices y solo los
+// invalida si la fila cambia algo, así que reimportar un archivo ya
+// cargado no reconstruye nada.
+void importUserRow(const ImportRow& row) {
+  userImport.rows++;
+
+  User candidate;
+  int userIndex = indexFindUserById(row.id);
+  if (userIndex >= 0) {
+    candidate = users[userIndex];
+  } else {
+    memset(&candidate, 0, sizeof(candidate));
+    memcpy(candidate.id, row.id, 5);
+    memset(candidate.password, 0xFF, 3);
+    candidate.isActive = true;
+  }
+
+  uint32_t value;
+  if (row.name && *row.name) {
+    memset(candidate.name, 0, sizeof(candidate.name));
+    strncpy(candidate.name, row.name, 10);
+  }
+  if (row.card && *row.card) {
+    if (!importNumber(row.card, value)) {
+      userImport.rejected++;
+      return;
+    }
+    candidate.cardId = value;
+  }
+  if (!importByte(row.dept, candidate.department) || !importByte(row.group, candidate.group)) {
+    userImport.rejected++;
+    return;
+  }
+  if (row.active && *row.active) {
+    candidate.isActive = (row.active[0] == '1' || row.active[0] == 't' || row.active[0] == 'T' ||
+                          row.active[0] == 's' || row.active[0] == 'S');
+  }
+
+  // La tarjeta no puede pertenecer ya a otro usuario activo
+  if (candidate.cardId != 0 && candidate.isActive) {
+    int owner = indexFindUserByCardId(candidate.cardId);
+    if (owner >= 0 && owner != userIndex) {
+      userImport.rejected++;
+      return;
+    }
+  }
+
+  if (userIndex >= 0) {
+    const User& current = users[userIndex];
+    if (strcmp(candidate.name, current.name) == 0 && candidate.cardId == current.cardId &&
+        candidate.department == current.department && candidate.group == current.group &&
+        candidate.isActive == current.isActive) {
+      userImport.unchanged++;
+      return;
+    }
+    candidate.version = noteUserChange(candidate.id, USER_CHANGE_UPDATE);
+    users[userIndex] = candidate;
+    userImport.updated++;
+  } else {
+    if (userCount >= MAX_USERS) {
+      userImport.full++;
+      return;
+    }
+    candidate.version = noteUserChange(candidate.id, USER_CHANGE_ADD);
+    users[userCount++] = candidate;
+    userImport.added++;
+  }
+  invalidateUserIndex();
+}
+
+// ========= CSV ===========
+// id,nombre,tarjeta,departamento,grupo,activo (o ';' como separador). Si la
+// primera línea no empieza por un número es una cabecera y las columnas se
+// asignan por su nombre (id, name/nombre, card/tarjeta, dept/departamento,
+// group/grupo, active/activo); las demás columnas se ignoran.
+
+uint8_t importFieldByName(const char* name) {
+  if (strcasecmp_P(name, PSTR("id")) == 0) return IMPORT_ID;
+  if (strcasecmp_P(name, PSTR("name")) == 0 || strcasecmp_P(name, PSTR("nombre")) == 0) return IMPORT_NAME;
+  if (strcasecmp_P(name, PSTR("card")) == 0 || strcasecmp_P(name, PSTR("tarjeta")) == 0) return IMPORT_CARD;
+  if (strcasecmp_P(name, PSTR("dept")) == 0 || strcasecmp_P(name, PSTR("departamento")) == 0) return IMPORT_DEPT;
+  if (strcasecmp_P(name, PSTR("group")) == 0 || strcasecmp_P(name, PSTR("grupo")) == 0) return IMPORT_GROUP;
+  if (strcasecmp_P(name, PSTR("active")) == 0 || strcasecmp_P(name, PSTR("activo")) == 0) return IMPORT_ACTIVE;
+  return IMPORT_SKIP;
+}
+
+// Separar la línea en campos sobre el propio búfer. Admite campos entre
+// comillas con "" como comilla escapada. Devuelve el número de campos.
+int importSplitCsv(char* line, char** fields) {
+  int count = 0;
+  char* in = line;
+  while (count < IMPORT_MAX_COLUMNS) {
+    while (*in == ' ') in++;
+    char* out = in;
+    fields[count++] = out;
+    if (*in == '"') {
+      in++;
+      while (*in) {
+        if (*in == '"' && in[1] == '"') {
+          *out++ = '"';
+          in += 2;
+        } else if (*in == '"') {
+          in++;
+          break;
+        } else {
+          *out++ = *in++;
+        }
+      }
+      while (*in && *in != userImport.separator) in++;
+    } else {
+      while (*in && *in != userImport.separator) *out++ = *in++;
+      while (out > fields[count - 1] && out[-1] == ' ') out--;
+    }
+    bool more = (*in == userImport.separator);
+    *out = 0;
+    if (!more) break;
+    in++;
+  }
+  return count;
+}
+
+void importCsvLine(char* line) {
+  if (line[0] == 0) return;
+
+  if (!userImport.headerChecked) {
+    userImport.headerChecked = true;
+    userImport.separator = (strchr(line, ';') != nullptr && strchr(line, ',') == nullptr) ? ';' : ',';
+    const char* first = line;
+    while (*first == ' ' || *first == '"') first++;
+    if (*first < '0' || *first > '9') {
+      char* names[IMPORT_MAX_COLUMNS];
+      userImport.columnCount = importSplitCsv(line, names);
+      for (int i = 0; i < userImport.columnCount; i++) {
+        userImport.columns[i] = importFieldByName(names[i]);
+      }
+      return;
+    }
+  }
+
+  char* fields[IMPORT_MAX_COLUMNS];
+  int count = importSplitCsv(line, fields);
+  ImportRow row = {};
+  bool hasId = false;
+  for (int i = 0; i < count && i < userImport.columnCount; i++) {
+    switch (userImport.columns[i]) {
+      case IMPORT_ID: hasId = parseUserId(fields[i], row.id); break;
+      case IMPORT_NAME: row.name = fields[i]; break;
+      case IMPORT_CARD: row.card = fields[i]; break;
+      case IMPORT_DEPT: row.dept = fields[i]; break;
+      case IMPORT_GROUP: row.group = fields[i]; break;
+      case IMPORT_ACTIVE: row.active = fields[i]; break;
+    }
+  }
+  if (!hasId) {
+    userImport.rows++;
+    userImport.rejected++;
+    return;
+  }
+  importUserRow(row);
+}
+
+// ========= JSON ===========
+// Un array de objetos o la salida de /api/users ({"users":[...]}). Se
+// captura cada objeto sin objetos anidados y se analiza por separado, así
+// que nunca hay un documento completo en memoria.
+
+// Texto de un campo numérico, venga como número o como cadena ("123");
+// importNumber lo valida después. nullptr si el campo no está.
+const char* importJsonField(JsonVariantConst value, char* buffer, size_t len) {
+  if (value.isNull()) return nullptr;
+  if (value.is<const char*>()) return value.as<const char*>();
+  if (measureJson(value) >= len) return "-";  // Demasiado largo: nunca es válido
+  serializeJson(value, buffer, len);
+  return buffer;
+}
+
+void importJsonObject(const char* text, size_t len) {
+  StaticJsonDocument<384> doc;  // En la pila: sin heap por cada fila
+  DeserializationError error = deserializeJson(doc, text, len);
+  if (error) {
+    userImport.rows++;
+    userImport.rejected++;
+    return;
+  }
+
+  // El ID puede venir como número o como texto
+  char idText[24];
+  char cardText[12] = "";
+  char deptText[4] = "";
+  char groupText[4] = "";
+  char activeText[2] = "";
+  serializeJson(doc["id"], idText, sizeof(idText));
+  const char* idValue = doc["id"].is<const char*>() ? doc["id"].as<const char*>() : idText;
+
+  ImportRow row = {};
+  if (!parseUserId(idValue, row.id)) {
+    userImport.rows++;
+    userImport.rejected++;
+    return;
+  }
+  row.name = doc["name"] | "";
+  row.card = importJsonField(doc["card"], cardText, sizeof(cardText));
+  row.dept = importJsonField(doc["dept"], deptText, sizeof(deptText));
+  row.group = importJsonField(doc["group"], groupText, sizeof(groupText));
+  if (!doc["active"].isNull()) {
+    activeText[0] = doc["active"].as<bool>() ? '1' : '0';
+    row.active = activeText;
+  }
+  importUserRow(row);
+}
+
+void importJsonChar(char c) {
+  if (userImport.capturing) {
+    if (userImport.lineLen < IMPORT_LINE_MAX) {
+      userImport.line[userImport.lineLen++] = c;
+    } else {
+      userImport.overflow = true;
+    }
+  }
+
+  if (userImport.inString) {
+    if (userImport.escape) userImport.escape = false;
+    else if (c == '\\') userImport.escape = true;
+    else if (c == '"') userImport.inString = false;
+    return;
+  }
+
+  if (c == '"') {
+    userImport.inString = true;
+  } else if (c == '{') {
+    // Empieza un objeto: si había otro abierto, era un contenedor
+    userImport.capturing = true;
+    userImport.overflow = false;
+    userImport.line[0] = '{';
+    userImport.lineLen = 1;
+  } else if (c == '}' && userImport.capturing) {
+    userImport.capturing = false;
+    if (userImport.overflow) {
+      userImport.rows++;
+      userImport.rejected++;
+    } else {
+      importJsonObject(userImport.line, userImport.lineLen);
+    }
+  }
+}
+
+// ========= FLUJO DE LA SUBIDA ===========
+
+void beginUserImport(const String& filename) {
+  memset(&userImport, 0, sizeof(userImport));
+  userImport.active = true;
+  userImport.separator = ',';
+  // Columnas por defecto si el CSV no tiene cabecera
+  static const uint8_t defaultColumns[] = { IMPORT_ID, IMPORT_NAME, IMPORT_CARD, IMPORT_DEPT, IMPORT_GROUP, IMPORT_ACTIVE };
+  memcpy(userImport.columns, defaultColumns, sizeof(defaultColumns));
+  userImport.columnCount = sizeof(defaultColumns);
+  if (filename.endsWith(".json")) {
+    userImport.json = true;
+    userImport.formatKnown = true;
+  }
+}
+
+// Procesar un trozo de la subida tal como llega
+void feedUserImport(const uint8_t* data, size_t len) {
+  if (!userImport.active) return;
+  for (size_t i = 0; i < len; i++) {
+    char c = data[i];
+
+    if (!userImport.formatKnown) {
+      if (c == ' ' || c == '\r' || c == '\n' || c == '\t' || (uint8_t)c >= 0x80) continue;  // Incluye BOM UTF-8
+      userImport.json = (c == '{' || c == '[');
+      userImport.formatKnown = true;
+    }
+
+    if (userImport.json) {
+      importJsonChar(c);
+      continue;
+    }
+
+    if (c == '\n') {
+      if (userImport.overflow) {
+        userImport.rows++;
+        userImport.rejected++;
+      } else {
+        userImport.line[userImport.lineLen] = 0;
+        importCsvLine(userImport.line);
+      }
+      userImport.lineLen = 0;
+      userImport.overflow = false;
+    } else if (c != '\r') {
+      if (userImport.lineLen < IMPORT_LINE_MAX - 1) {
+        userImport.line[userImport.lineLen++] = c;
+      } else {
+        userImport.overflow = true;
+      }
+    }
+  }
+}
+
+// Terminar: última línea sin salto y un único guardado de users.json
+void endUserImport() {
+  if (!userImport.active) return;
+  if (!userImport.json && userImport.lineLen > 0 && !userImport.overflow) {
+    userImport.line[userImport.lineLen] = 0;
+    importCsvLine(userImport.line);
+  }
+  userImport.active = false;
+  if (userImport.added + userImport.updated > 0) {
+    saveUsers();
+  }
+}
+
+// Subida interrumpida: los cambios ya aplicados en RAM se guardan igual,
+// para que la tabla en flash no quede atrás de la que se está usando
+void abortUserImport() {
+  userImport.lineLen = 0;
+  endUserImport();
+}
+
+#endif // IMPORTACION_H
@@ -0,0 +1,98 @@
+/**
+ * indices.h
+ * Índices ordenados sobre la tabla de usuarios (por ID y por tarjeta)
+ */
+
+#ifndef INDICES_H
+#define INDICES_H
+
+// Los índices guardan posiciones de users[] ordenadas por clave, así que
+// ocupan un byte por usuario. Se reconstruyen de forma perezosa en la
+// primera búsqueda tras cualquier cambio en la tabla.
+uint8_t userIdOrder[MAX_USERS];     // Posiciones ordenadas por ID (5 bytes, big-endian)
+uint8_t userCardOrder[MAX_USERS];   // Posiciones de usuarios activos ordenadas por tarjeta
+int userCardOrderCount = 0;         // Entradas válidas en userCardOrder
+bool userIndexDirty = true;         // Hay que reconstruir antes de buscar
+uint32_t userTableGeneration = 0;   // Cambia con cada modificación de users[]
+
+// Marcar los índices como obsoletos. Llamar tras modificar users[] o userCount.
+void invalidateUserIndex() {
+  userIndexDirty = true;
+  userTableGeneration++;
+}
+
+// Ordenación por inserción estable: con 100 usuarios es suficiente y no usa heap.
+// A igual clave se conserva el orden de users[], igual que la búsqueda lineal.
+void rebuildUserIndex() {
+  for (int i = 0; i < userCount; i++) {
+    int j = i;
+    while (j > 0 && memcmp(users[userIdOrder[j - 1]].id, users[i].id, 5) > 0) {
+      userIdOrder[j] = userIdOrder[j - 1];
+      j--;
+    }
+    userIdOrder[j] = i;
+  }
+
+  userCardOrderCount = 0;
+  for (int i = 0; i < userCount; i++) {
+    if (!users[i].isActive) continue;
+    int j = userCardOrderCount++;
+    while (j > 0 && users[userCardOrder[j - 1]].cardId > users[i].cardId) {
+      userCardOrder[j] = userCardOrder[j - 1];
+      j--;
+    }
+    userCardOrder[j] = i;
+  }
+
+  userIndexDirty = false;
+}
+
+// Buscar un usuario por ID en O(log n). Devuelve la posición en users[] o -1.
+int indexFindUserById(const uint8_t* id) {
+  if (userIndexDirty) rebuildUserIndex();
+  int lo = 0;
+  int hi = userCount;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (memcmp(users[userIdOrder[mid]].id, id, 5) < 0) lo = mid + 1;
+    else hi = mid;
+  }
+  if (lo < userCount && memcmp(users[userIdOrder[lo]].id, id, 5) == 0) {
+    return userIdOrder[lo];
+  }
+  return -1;
+}
+
+// Primera posición de userIdOrder con un ID mayor que id (desde el principio
+// si id es nullptr); userCount si no queda ninguno. Sirve para recorrer los
+// usuarios por ID aunque la tabla cambie entre un paso y el siguiente.
+int indexUserIdAfter(const uint8_t* id) {
+  if (userIndexDirty) rebuildUserIndex();
+  if (id == nullptr) return 0;
+  int lo = 0;
+  int hi = userCount;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (memcmp(users[userIdOrder[mid]].id, id, 5) <= 0) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+// Buscar un usuario activo por tarjeta en O(log n). Devuelve la posición o -1.
+int indexFindUserByCardId(uint32_t cardId) {
+  if (userIndexDirty) rebuildUserIndex();
+  int lo = 0;
+  int hi = userCardOrderCount;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (users[userCardOrder[mid]].cardId < cardId) lo = mid + 1;
+    else hi = mid;
+  }
+  if (lo < userCardOrderCount && users[userCardOrder[lo]].cardId == cardId) {
+    return userCardOrder[lo];
+  }
+  return -1;
+}
+
+#endif // INDICES_H
@@ -0,0 +1,210 @@
+/**
+ * lectores.h
+ * Lectores Wiegand: estado de las interrupciones de cada lector y colas de
+ * tramas completas pendientes de decidir
+ */
+
+#ifndef LECTORES_H
+#define LECTORES_H
+
+#define WIEGAND_TIMEOUT 25  // Fin de trama tras este tiempo sin bits (ms)
+#define WIEGAND_MAX_BITS 64 // Capacidad del acumulador
+
+WiegandReader wiegandReaders[MAX_READERS];
+
+// ========= MANEJADORES DE INTERRUPCIÓN ===========
+// Cada lector registra sus ISR con su propio estado como argumento, así dos
+// lectores que transmiten a la vez no se mezclan.
+
+ICACHE_RAM_ATTR void handleD0(void* arg) {
+  WiegandReader* reader = (WiegandReader*)arg;
+  reader->lastBit = millis();
+  if (reader->bitCount < WIEGAND_MAX_BITS) {
+    reader->bitCount++;
+    reader->data = reader->data << 1;  // Shift left y agregar 0
+  }
+}
+
+ICACHE_RAM_ATTR void handleD1(void* arg) {
+  WiegandReader* reader = (WiegandReader*)arg;
+  reader->lastBit = millis();
+  if (reader->bitCount < WIEGAND_MAX_BITS) {
+    reader->bitCount++;
+    reader->data = (reader->data << 1) | 1;  // Shift left y agregar 1
+  }
+}
+
+// Configurar pines e interrupciones de los lectores configurados
+void setupWiegandReaders() {
+  for (int i = 0; i < basicConfig.readerCount; i++) {
+    const ReaderConfig& config = basicConfig.readers[i];
+    pinMode(config.pin_d0, INPUT_PULLUP);  // Wiegand Data0
+    pinMode(config.pin_d1, INPUT_PULLUP);  // Wiegand Data1
+    attachInterruptArg(digitalPinToInterrupt(config.pin_d0), handleD0, &wiegandReaders[i], FALLING);
+    attachInterruptArg(digitalPinToInterrupt(config.pin_d1), handleD1, &wiegandReaders[i], FALLING);
+  }
+}
+
+// ========= COLAS DE TRAMAS ===========
+
+// Mover a la cola de cada lector las tramas terminadas. La copia y el
+// reinicio se hacen con las interrupciones desactivadas para no perder los
+// primeros bits de una tarjeta que llegue justo después.
+void captureWiegandFrames() {
+  for (int i = 0; i < basicConfig.readerCount; i++) {
+    WiegandReader& reader = wiegandReaders[i];
+    if (reader.bitCount == 0 || millis() - reader.lastBit <= WIEGAND_TIMEOUT) continue;
+
+    WiegandFrame frame;
+    noInterrupts();
+    if (reader.bitCount == 0 || millis() - reader.lastBit <= WIEGAND_TIMEOUT) {
+      interrupts();
+      continue;
+    }
+    frame.data = reader.data;
+    frame.bits = reader.bitCount;
+    reader.data = 0;
+    reader.bitCount = 0;
+    interrupts();
+
+    if (reader.count == WIEGAND_QUEUE_SIZE) {
+      // Cola llena: descartar la más antigua
+      reader.head = (reader.head + 1) % WIEGAND_QUEUE_SIZE;
+      reader.count--;
+      reader.overruns++;
+    }
+    reader.queue[(reader.head + reader.count) % WIEGAND_QUEUE_SIZE] = frame;
+    reader.count++;
+  }
+}
+
+// Tomar la siguiente trama pendiente, alternando entre lectores para que uno
+// con mucho tráfico no retrase a los demás. Devuelve false si no hay ninguna.
+bool nextWiegandFrame(uint8_t& readerIndex, WiegandFrame& frame) {
+  static uint8_t nextReader = 0;
+  for (int n = 0; n < basicConfig.readerCount; n++) {
+    uint8_t i = (nextReader + n) % basicConfig.readerCount;
+    WiegandReader& reader = wiegandReaders[i];
+    if (reader.count == 0) continue;
+
+    frame = reader.queue[reader.head];
+    reader.head = (reader.head + 1) % WIEGAND_QUEUE_SIZE;
+    reader.count--;
+    readerIndex = i;
+    nextReader = (i + 1) % basicConfig.readerCount;
+    return true;
+  }
+  return false;
+}
+
+// ========= FORMATOS DE TARJETA ===========
+// Cada formato se describe con un descriptor constexpr. Las posiciones se
+// cuentan desde el primer bit recibido (0), como en las hojas de formato.
+// decodeWiegand<F> se instancia una vez por formato, así que los
+// desplazamientos y máscaras quedan como constantes en el código y
+// decodeWiegandFrame solo elige la instancia por la longitud de la trama.
+
+enum WiegandDecodeResult { WIEGAND_DECODED, WIEGAND_BAD_PARITY, WIEGAND_UNKNOWN_FORMAT, WIEGAND_ID_TOO_WIDE };
+
+#define WIEGAND_MAX_PARITY 3
+
+// Bit de paridad: su posición, los bits que cubre y si es impar
+struct WiegandParity {
+  uint8_t position;
+  uint64_t covered;     // Máscara sobre la trama (sin el propio bit de paridad)
+  bool odd;
+};
+
+struct WiegandFormat {
+  uint8_t bits;
+  uint8_t facilityStart;
+  uint8_t facilityLength;
+  uint8_t cardStart;
+  uint8_t cardLength;
+  uint8_t parityCount;
+  WiegandParity parity[WIEGAND_MAX_PARITY];
+};
+
+// Máscara de un bit por su posición desde el primer bit recibido
+constexpr uint64_t wiegandBit(uint8_t bits, uint8_t position) {
+  return 1ULL << (bits - 1 - position);
+}
+
+// Máscara de las posiciones [from, to]
+constexpr uint64_t wiegandRange(uint8_t bits, uint8_t from, uint8_t to) {
+  return (from > to) ? 0 : (wiegandBit(bits, from) | wiegandRange(bits, from + 1, to));
+}
+
+// Máscara de las posiciones [from, to] salvo las que cumplen p % 3 == skip
+// (paridades intercaladas del formato Corporate 1000)
+constexpr uint64_t wiegandStripe(uint8_t bits, uint8_t from, uint8_t to, uint8_t skip) {
+  return (from > to) ? 0 : (((from % 3 == skip) ? 0 : wiegandBit(bits, from)) | wiegandStripe(bits, from + 1, to, skip));
+}
+
+// H10301: 8 bits de sitio, 16 de tarjeta
+constexpr WiegandFormat WIEGAND_26 = { 26, 1, 8, 9, 16, 2, {
+  { 0, wiegandRange(26, 1, 12), false },
+  { 25, wiegandRange(26, 13, 24), true } } };
+
+// 16 bits de sitio, 16 de tarjeta
+constexpr WiegandFormat WIEGAND_34 = { 34, 1, 16, 17, 16, 2, {
+  { 0, wiegandRange(34, 1, 16), false },
+  { 33, wiegandRange(34, 17, 32), true } } };
+
+// HID Corporate 1000: 12 bits de empresa, 20 de tarjeta
+constexpr WiegandFormat WIEGAND_35 = { 35, 2, 12, 14, 20, 3, {
+  { 1, wiegandStripe(35, 2, 33, 1), false },
+  { 34, wiegandStripe(35, 1, 33, 0), true },
+  { 0, wiegandRange(35, 1, 34), true } } };
+
+// H10304: 16 bits de sitio, 19 de tarjeta
+constexpr WiegandFormat WIEGAND_37 = { 37, 1, 16, 17, 19, 2, {
+  { 0, wiegandRange(37, 1, 18), false },
+  { 36, wiegandRange(37, 18, 35), true } } };
+
+// HID Corporate 1000 de 48 bits: 22 bits de empresa, 23 de tarjeta
+constexpr WiegandFormat WIEGAND_48 = { 48, 2, 22, 24, 23, 3, {
+  { 1, wiegandStripe(48, 2, 46, 1), false },
+  { 47, wiegandStripe(48, 1, 46, 0), true },
+  { 0, wiegandRange(48, 1, 47), true } } };
+
+// Extraer un campo de la trama
+template <const WiegandFormat& F>
+inline uint32_t wiegandField(uint64_t data, uint8_t start, uint8_t length) {
+  return (data >> (F.bits - start - length)) & ((1ULL << length) - 1);
+}
+
+// Decodificar una trama de formato F. El identificador de tarjeta es
+// sitio:tarjeta concatenados. La tabla de usuarios, el protocolo y los
+// registros usan tarjetas de 32 bits, así que en los formatos de más de 32
+// bits útiles (37 y 48) solo se aceptan las tarjetas cuyo identificador
+// cabe entero (sitio < 8192 en H10304, empresa < 512 en Corporate 1000 de
+// 48 bits). Recortarlo haría que tarjetas de sitios distintos coincidieran.
+template <const WiegandFormat& F>
+WiegandDecodeResult decodeWiegand(uint64_t data, uint32_t& cardId) {
+  for (int i = 0; i < F.parityCount; i++) {
+    const WiegandParity& p = F.parity[i];
+    uint8_t ones = __builtin_popcountll(data & (p.covered | wiegandBit(F.bits, p.position)));
+    if ((ones & 1) != (p.odd ? 1 : 0)) return WIEGAND_BAD_PARITY;
+  }
+  uint64_t facility = wiegandField<F>(data, F.facilityStart, F.facilityLength);
+  uint64_t card = wiegandField<F>(data, F.cardStart, F.cardLength);
+  uint64_t fullId = (facility << F.cardLength) | card;
+  if (fullId > 0xFFFFFFFFULL) return WIEGAND_ID_TOO_WIDE;
+  cardId = fullId;
+  return WIEGAND_DECODED;
+}
+
+// Elegir el decodificador por la longitud de la trama
+WiegandDecodeResult decodeWiegandFrame(const WiegandFrame& frame, uint32_t& cardId) {
+  switch (frame.bits) {
+    case 26: return decodeWiegand<WIEGAND_26>(frame.data, cardId);
+    case 34: return decodeWiegand<WIEGAND_34>(frame.data, cardId);
+    case 35: return decodeWiegand<WIEGAND_35>(frame.data, cardId);
+    case 37: return decodeWiegand<WIEGAND_37>(frame.data, cardId);
+    case 48: return decodeWiegand<WIEGAND_48>(frame.data, cardId);
+    default: return WIEGAND_UNKNOWN_FORMAT;
+  }
+}
+
+#endif // LECTORES_H
@@ -0,0 +1,186 @@
+/**
+ * metricas.h
+ * Contadores de funcionamiento y endpoint /metrics en formato de texto Prometheus
+ */
+
+#ifndef METRICAS_H
+#define METRICAS_H
+
+// Declaración de funciones externas (definidas en web.h)
+extern bool isAuthenticated();
+
+// Declaración de variables externas (definidas en sesion.h)
+extern uint16_t txCount;
+extern bool sessionActive;
+
+Metrics metrics;  // Inicializado a cero por ser global
+
+// Límites superiores de las cubetas del histograma del loop (µs)
+static const uint32_t loopBucketBounds[LOOP_HISTOGRAM_BUCKETS] PROGMEM = {
+  100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 1000000
+};
+
+// Límites superiores de las cubetas del histograma de sesiones TCP (s)
+static const uint32_t sessionBucketBounds[SESSION_LIFETIME_BUCKETS] PROGMEM = {
+  10, 60, 300, 1800, 3600, 14400
+};
+
+// Nombre del motivo de cierre en la etiqueta "reason"
+static const char* const sessionCloseNames[SESSION_CLOSE_COUNT] = { "peer", "idle", "replaced", "stalled" };
+
+// ========= REGISTRO DE MEDICIONES ===========
+
+// Registrar la duración de una iteración del loop
+void recordLoopDuration(uint32_t duration) {
+  int bucket = 0;
+  while (bucket < LOOP_HISTOGRAM_BUCKETS && duration > pgm_read_dword(&loopBucketBounds[bucket])) {
+    bucket++;
+  }
+  metrics.loopHistogram[bucket]++;
+  metrics.loopTotalMicros += duration;
+  metrics.loopCount++;
+}
+
+// Registrar el cierre de una sesión TCP y su duración (s)
+void recordSessionClose(uint8_t reason, uint32_t lifetime) {
+  int bucket = 0;
+  while (bucket < SESSION_LIFETIME_BUCKETS && lifetime > pgm_read_dword(&sessionBucketBounds[bucket])) {
+    bucket++;
+  }
+  metrics.sessionLifetimeHistogram[bucket]++;
+  metrics.sessionLifetimeTotal += lifetime;
+  metrics.sessionCloses[reason]++;
+}
+
+// Estimar un percentil (0-1) del loop como el límite superior de la cubeta
+// donde la frecuencia acumulada alcanza el percentil. Devuelve µs.
+uint32_t loopPercentile(float q) {
+  if (metrics.loopCount == 0) return 0;
+  uint32_t target = (uint32_t)(q * metrics.loopCount);
+  if (target == 0) target = 1;
+  uint32_t cumulative = 0;
+  for (int i = 0; i < LOOP_HISTOGRAM_BUCKETS; i++) {
+    cumulative += metrics.loopHistogram[i];
+    if (cumulative >= target) return pgm_read_dword(&loopBucketBounds[i]);
+  }
+  return pgm_read_dword(&loopBucketBounds[LOOP_HISTOGRAM_BUCKETS - 1]);
+}
+
+// ========= SALIDA EN FORMATO PROMETHEUS ===========
+// Todo el texto se agrupa en responseWriter (respuestas.h), sin String ni heap.
+
+// Escribir una métrica simple con su cabecera TYPE
+void metricsWriteValue(const char* name, const char* type, uint32_t value) {
+  responsePrintf(PSTR("# TYPE %s %s\n%s %u\n"), name, type, name, value);
+}
+
+// GET /metrics
+void handleMetrics() {
+  if (!isAuthenticated()) return;
+
+  responseBegin(200, "text/plain; version=0.0.4");
+
+  metricsWriteValue("anviz_access_granted_total", "counter", metrics.accessGranted);
+  metricsWriteValue("anviz_access_denied_total", "counter", metrics.accessDenied);
+  metricsWriteValue("anviz_frame_crc_errors_total", "counter", metrics.frameCrcErrors);
+  metricsWriteValue("anviz_frame_incomplete_total", "counter", metrics.frameIncomplete);
+  metricsWriteValue("anviz_frame_stx_errors_total", "counter", metrics.frameStxErrors);
+  metricsWriteValue("anviz_wifi_reconnects_total", "counter", metrics.wifiReconnects);
+  metricsWriteValue("anviz_swipes_suppressed_total", "counter", metrics.swipesSuppressed);
+  metricsWriteValue("anviz_access_throttled_total", "counter", metrics.accessThrottled);
+  metricsWriteValue("anviz_negative_cache_hits_total", "counter", metrics.negativeCacheHits);
+  metricsWriteValue("anviz_wiegand_parity_errors_total", "counter", metrics.wiegandParityErrors);
+  metricsWriteValue("anviz_wiegand_unknown_formats_total", "counter", metrics.wiegandUnknownFormats);
+  metricsWriteValue("anviz_wiegand_wide_ids_total", "counter", metrics.wiegandWideIds);
+  metricsWriteValue("anviz_schedule_unsynced_total", "counter", metrics.scheduleUnsynced);
+  metricsWriteValue("anviz_push_batches_total", "counter", metrics.pushBatches);
+  metricsWriteValue("anviz_push_records_total", "counter", metrics.pushRecords);
+  metricsWriteValue("anviz_push_failures_total", "counter", metrics.pushFailures);
+  metricsWriteValue("anviz_push_skipped_total", "counter", metrics.pushSkipped);
+  metricsWriteValue("anviz_mqtt_published_total", "counter", metrics.mqttPublished);
+  metricsWriteValue("anviz_mqtt_queued_total", "counter", metrics.mqttQueued);
+  metricsWriteValue("anviz_mqtt_dropped_total", "counter", metrics.mqttDropped);
+  metricsWriteValue("anviz_mqtt_reconnects_total", "counter", metrics.mqttReconnects);
+  metricsWriteValue("anviz_tx_deferred_total", "counter", metrics.txDeferred);
+  metricsWriteValue("anviz_tx_backpressure_total", "counter", metrics.txBackpressure);
+  metricsWriteValue("anviz_tx_overflows_total", "counter", metrics.txOverflows);
+  metricsWriteValue("anviz_sessions_opened_total", "counter", metrics.sessionsOpened);
+  metricsWriteValue("anviz_sessions_rejected_total", "counter", metrics.sessionsRejected);
+
+  // Sesiones TCP cerradas por motivo y su duración (segundos)
+  responsePrintf(PSTR("# TYPE anviz_sessions_closed_total counter\n"));
+  uint32_t sessionsClosed = 0;
+  for (int i = 0; i < SESSION_CLOSE_COUNT; i++) {
+    responsePrintf(PSTR("anviz_sessions_closed_total{reason=\"%s\"} %u\n"), sessionCloseNames[i], metrics.sessionCloses[i]);
+    sessionsClosed += metrics.sessionCloses[i];
+  }
+  responsePrintf(PSTR("# TYPE anviz_session_lifetime_seconds histogram\n"));
+  uint32_t sessionCumulative = 0;
+  for (int i = 0; i < SESSION_LIFETIME_BUCKETS; i++) {
+    sessionCumulative += metrics.sessionLifetimeHistogram[i];
+    responsePrintf(PSTR("anviz_session_lifetime_seconds_bucket{le=\"%u\"} %u\n"),
+                  pgm_read_dword(&sessionBucketBounds[i]), sessionCumulative);
+  }
+  responsePrintf(PSTR("anviz_session_lifetime_seconds_bucket{le=\"+Inf\"} %u\n"), sessionsClosed);
+  responsePrintf(PSTR("anviz_session_lifetime_seconds_sum %u\n"), metrics.sessionLifetimeTotal);
+  responsePrintf(PSTR("anviz_session_lifetime_seconds_count %u\n"), sessionsClosed);
+
+  // Tramas Wiegand descartadas por cola llena, por lector
+  responsePrintf(PSTR("# TYPE anviz_wiegand_overruns_total counter\n"));
+  for (int i = 0; i < basicConfig.readerCount; i++) {
+    responsePrintf(PSTR("anviz_wiegand_overruns_total{reader=\"%d\"} %u\n"), i, wiegandReaders[i].overruns);
+  }
+
+  // Comandos por código de operación (solo los que se han recibido)
+  responsePrintf(PSTR("# TYPE anviz_commands_total counter\n"));
+  for (int i = 0; i < 128; i++) {
+    if (metrics.commandCounts[i] > 0) {
+      responsePrintf(PSTR("anviz_commands_total{opcode=\"0x%02X\"} %u\n"), i, metrics.commandCounts[i]);
+    }
+  }
+
+  responsePrintf(PSTR("# TYPE anviz_flash_bytes_written_total counter\n"));
+  responsePrintf(PSTR("anviz_flash_bytes_written_total{file=\"records\"} %u\n"), metrics.flashBytesRecords);
+  responsePrintf(PSTR("anviz_flash_bytes_written_total{file=\"users\"} %u\n"), metrics.flashBytesUsers);
+  responsePrintf(PSTR("anviz_flash_bytes_written_total{file=\"attendance\"} %u\n"), metrics.flashBytesAttendance);
+
+  metricsWriteValue("anviz_heap_free_bytes", "gauge", ESP.getFreeHeap());
+  metricsWriteValue("anviz_heap_max_block_bytes", "gauge", ESP.getMaxFreeBlockSize());
+  metricsWriteValue("anviz_heap_fragmentation_percent", "gauge", ESP.getHeapFragmentation());
+  metricsWriteValue("anviz_users", "gauge", userCount);
+  metricsWriteValue("anviz_records_stored", "gauge", storedRecordCount());
+  metricsWriteValue("anviz_records_new", "gauge", newRecordCount);
+  metricsWriteValue("anviz_push_pending", "gauge", pushConfig.enabled ? recordCount - pushCursor : 0);
+  metricsWriteValue("anviz_tx_queued_bytes", "gauge", txCount);
+  metricsWriteValue("anviz_session_open", "gauge", sessionActive ? 1 : 0);
+  metricsWriteValue("anviz_uptime_seconds", "counter", millis() / 1000);
+
+  // Histograma de duración del loop (segundos)
+  responsePrintf(PSTR("# TYPE anviz_loop_duration_seconds histogram\n"));
+  uint32_t cumulative = 0;
+  for (int i = 0; i < LOOP_HISTOGRAM_BUCKETS; i++) {
+    cumulative += metrics.loopHistogram[i];
+    uint32_t bound = pgm_read_dword(&loopBucketBounds[i]);
+    responsePrintf(PSTR("anviz_loop_duration_seconds_bucket{le=\"%u.%06u\"} %u\n"),
+                  bound / 1000000, bound % 1000000, cumulative);
+  }
+  responsePrintf(PSTR("anviz_loop_duration_seconds_bucket{le=\"+Inf\"} %u\n"), metrics.loopCount);
+  uint32_t totalSeconds = metrics.loopTotalMicros / 1000000;
+  uint32_t totalMicros = metrics.loopTotalMicros % 1000000;
+  responsePrintf(PSTR("anviz_loop_duration_seconds_sum %u.%06u\n"), totalSeconds, totalMicros);
+  responsePrintf(PSTR("anviz_loop_duration_seconds_count %u\n"), metrics.loopCount);
+
+  // Percentiles estimados a partir del histograma
+  static const float quantiles[] = { 0.5f, 0.9f, 0.99f };
+  static const char* const quantileLabels[] = { "0.5", "0.9", "0.99" };
+  responsePrintf(PSTR("# TYPE anviz_loop_duration_quantile_seconds gauge\n"));
+  for (int i = 0; i < 3; i++) {
+    uint32_t value = loopPercentile(quantiles[i]);
+    responsePrintf(PSTR("anviz_loop_duration_quantile_seconds{quantile=\"%s\"} %u.%06u\n"),
+                  quantileLabels[i], value / 1000000, value % 1000000);
+  }
+
+  responseEnd();
+}
+
+#endif // METRICAS_H
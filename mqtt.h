@@ -0,0 +1,281 @@
+/**
+ * mqtt.h
+ * Publicación de eventos de acceso por MQTT con cola en flash cuando no hay
+ * conexión, y órdenes remotas (apertura y activación de usuarios)
+ */
+
+#ifndef MQTT_H
+#define MQTT_H
+
+#define MQTT_RECONNECT_MIN 5000       // Primer reintento de conexión (ms)
+#define MQTT_CONNECT_TIMEOUT 300      // Conexión TCP con el broker; bloquea el loop (ms)
+#define MQTT_SOCKET_TIMEOUT 1         // Espera de CONNACK tras conectar (s)
+#define MQTT_RECONNECT_MAX 60000      // Máximo entre reintentos (ms)
+#define MQTT_HEARTBEAT_INTERVAL 60000 // Latido en <prefijo>/heartbeat (ms)
+#define MQTT_QUEUE_MAX_EVENTS 1000    // Eventos en la cola de flash (~20 KB)
+#define MQTT_DRAIN_BATCH 10           // Eventos de la cola publicados por pasada del loop
+#define MQTT_RAM_QUEUE 16             // Eventos recientes a la espera de pumpMqtt()
+#define MQTT_USERS_SAVE_DELAY 5000    // Guardar usuarios tras un cambio remoto (ms)
+#define MQTT_QUEUE_MAGIC 0x3151514DUL // "MQQ1"
+
+// Declaración de funciones externas (definidas en almacenamiento.h)
+extern void saveUsers();
+
+WiFiClient mqttNetClient;
+PubSubClient mqttClient(mqttNetClient);
+OutboundTarget mqttTarget = {};
+AccessEvent mqttRamQueue[MQTT_RAM_QUEUE]; // Eventos emitidos aún sin publicar ni guardar
+uint8_t mqttRamHead = 0;
+uint8_t mqttRamCount = 0;
+unsigned long mqttRetryAt = 0;
+uint32_t mqttRetryDelay = MQTT_RECONNECT_MIN;
+unsigned long mqttLastHeartbeat = 0;
+bool mqttQueueHasEvents = false;      // Hay eventos pendientes en /mqtt_queue.bin
+bool mqttUsersDirty = false;          // Usuarios cambiados por orden remota, sin guardar
+unsigned long mqttUsersChangedAt = 0;
+
+// Cabecera de la cola en flash. Los eventos se añaden al final y head cuenta
+// los ya publicados; el archivo se borra al vaciarse.
+typedef struct {
+  uint32_t magic;
+  uint32_t head;
+} MqttQueueHeader;
+
+// Componer un topic bajo el prefijo configurado
+void mqttTopic(char* buffer, size_t len, const char* suffix) {
+  snprintf_P(buffer, len, PSTR("%s/%s"), mqttConfig.prefix[0] ? mqttConfig.prefix : "anviz", suffix);
+}
+
+// ========= PUBLICACIÓN ===========
+
+// Mensaje compacto de un evento en <prefijo>/event
+bool mqttPublishEvent(const AccessEvent& event) {
+  char topic[48];
+  char payload[128];
+  char idText[16] = "";
+  if (event.kind != EVENT_DENIED && event.kind != EVENT_FORCED_UNLOCK) {
+    formatUserId(idText, sizeof(idText), event.id);
+  }
+  mqttTopic(topic, sizeof(topic), "event");
+  snprintf_P(payload, sizeof(payload), PSTR("{\"r\":\"%s\",\"seq\":%u,\"ts\":%u,\"card\":%u,\"user\":\"%s\",\"type\":%u}"),
+             accessEventKindName(event.kind), event.seq, event.timestamp + 946684800UL,
+             event.cardId, idText, event.recordType);
+  if (!mqttClient.publish(topic, payload, false)) return false;
+  metrics.mqttPublished++;
+  return true;
+}
+
+// Guardar los eventos de la cola de RAM al final de la cola de flash, con
+// una sola apertura del archivo
+void mqttStoreRamQueue() {
+  File file = SPIFFS.open("/mqtt_queue.bin", "r+");
+  if (!file) {
+    file = SPIFFS.open("/mqtt_queue.bin", "w");
+    if (!file) return;  // Se reintenta en la próxima pasada
+    MqttQueueHeader header = { MQTT_QUEUE_MAGIC, 0 };
+    file.write((const uint8_t*)&header, sizeof(header));
+  }
+  uint32_t stored = (file.size() - sizeof(MqttQueueHeader)) / sizeof(AccessEvent);
+  file.seek(0, SeekEnd);
+  while (mqttRamCount > 0) {
+    if (stored >= MQTT_QUEUE_MAX_EVENTS) {
+      // Cola llena: se conservan los más antiguos
+      metrics.mqttDropped++;
+    } else {
+      file.write((const uint8_t*)&mqttRamQueue[mqttRamHead], sizeof(AccessEvent));
+      stored++;
+      mqttQueueHasEvents = true;
+      metrics.mqttQueued++;
+    }
+    mqttRamHead = (mqttRamHead + 1) % MQTT_RAM_QUEUE;
+    mqttRamCount--;
+  }
+  file.close();
+}
+
+// Publicar la cola de RAM mientras el broker acepte; el resto queda en ella
+void mqttPublishRamQueue() {
+  while (mqttRamCount > 0 && mqttPublishEvent(mqttRamQueue[mqttRamHead])) {
+    mqttRamHead = (mqttRamHead + 1) % MQTT_RAM_QUEUE;
+    mqttRamCount--;
+  }
+}
+
+// Llamado desde emitAccessEvent, dentro de la decisión de acceso: solo copia
+// el evento a la cola de RAM, sin red ni flash. pumpMqtt() lo publica o,
+// sin conexión, lo pasa a la cola de flash.
+void mqttQueueEvent(const AccessEvent& event) {
+  if (!mqttConfig.enabled || mqttConfig.host[0] == 0) return;
+  if (mqttRamCount >= MQTT_RAM_QUEUE) {
+    metrics.mqttDropped++;
+    return;
+  }
+  mqttRamQueue[(mqttRamHead + mqttRamCount) % MQTT_RAM_QUEUE] = event;
+  mqttRamCount++;
+}
+
+// Publicar un lote de la cola de flash. Si una publicación falla, el resto
+// queda para la próxima pasada.
+void mqttDrainQueue() {
+  File file = SPIFFS.open("/mqtt_queue.bin", "r+");
+  if (!file) {
+    mqttQueueHasEvents = false;
+    return;
+  }
+  MqttQueueHeader header;
+  if (file.read((uint8_t*)&header, sizeof(header)) != sizeof(header) || header.magic != MQTT_QUEUE_MAGIC) {
+    file.close();
+    SPIFFS.remove("/mqtt_queue.bin");
+    mqttQueueHasEvents = false;
+    return;
+  }
+
+  uint32_t total = (file.size() - sizeof(header)) / sizeof(AccessEvent);
+  file.seek(sizeof(header) + header.head * sizeof(AccessEvent), SeekSet);
+  for (int n = 0; n < MQTT_DRAIN_BATCH && header.head < total; n++) {
+    AccessEvent event;
+    if (file.read((uint8_t*)&event, sizeof(event)) != sizeof(event)) break;
+    if (!mqttPublishEvent(event)) break;
+    header.head++;
+  }
+
+  if (header.head >= total) {
+    file.close();
+    SPIFFS.remove("/mqtt_queue.bin");
+    mqttQueueHasEvents = false;
+    return;
+  }
+  file.seek(0, SeekSet);
+  file.write((const uint8_t*)&header, sizeof(header));
+  file.close();
+}
+
+// Latido con el estado del equipo en <prefijo>/heartbeat
+void mqttPublishHeartbeat() {
+  char topic[48];
+  char payload[160];
+  mqttTopic(topic, sizeof(topic), "heartbeat");
+  snprintf_P(payload, sizeof(payload), PSTR("{\"up\":%u,\"heap\":%u,\"rssi\":%d,\"users\":%d,\"records\":%u,\"queued\":%s}"),
+             (unsigned)(millis() / 1000), ESP.getFreeHeap(), WiFi.RSSI(), userCount, recordCount,
+             mqttQueueHasEvents ? "true" : "false");
+  mqttClient.publish(topic, payload, false);
+}
+
+// ========= ÓRDENES REMOTAS ===========
+// Se aplican en RAM dentro del callback, en la misma pasada del loop en que
+// llegan; solo la escritura de users.json se aplaza para agrupar cambios.
+
+// <prefijo>/cmd/unlock: apertura forzada (cualquier contenido)
+// <prefijo>/cmd/user/<id>: "1" activa y "0" desactiva al usuario
+void mqttCallback(char* topic, uint8_t* payload, unsigned int length) {
+  char base[48];
+  mqttTopic(base, sizeof(base), "cmd/");
+  size_t baseLen = strlen(base);
+  if (strncmp(topic, base, baseLen) != 0) return;
+  const char* command = topic + baseLen;
+
+  if (strcmp_P(command, PSTR("unlock")) == 0) {
+    triggerForcedUnlock();
+    return;
+  }
+
+  if (strncmp_P(command, PSTR("user/"), 5) == 0 && length > 0) {
+    uint8_t id[5];
+    if (!parseUserId(command + 5, id)) return;
+    int userIndex = indexFindUserById(id);
+    if (userIndex < 0) return;
+    bool active = (payload[0] == '1');
+    if (users[userIndex].isActive != active) {
+      users[userIndex].isActive = active;
+      users[userIndex].version = noteUserChange(id, USER_CHANGE_UPDATE);
+      invalidateUserIndex();
+      mqttUsersDirty = true;
+      mqttUsersChangedAt = millis();
+    }
+  }
+}
+
+// ========= CONEXIÓN ===========
+
+// Retomar la cola de flash que quedara de antes del reinicio
+void setupMqtt() {
+  mqttQueueHasEvents = SPIFFS.exists("/mqtt_queue.bin");
+}
+
+// Conectar con el broker: estado en <prefijo>/status (retenido, con
+// testamento "offline") y suscripción a <prefijo>/cmd/#. La conexión TCP la
+// abre connectOutbound() (IP ya resuelta, MQTT_CONNECT_TIMEOUT) y
+// PubSubClient reutiliza el socket ya conectado, así que un broker caído
+// detiene el loop como mucho MQTT_CONNECT_TIMEOUT por reintento, y uno que
+// acepta la conexión sin responder, MQTT_SOCKET_TIMEOUT.
+bool mqttConnect() {
+  char clientId[24];
+  char statusTopic[48];
+  char commandTopic[48];
+  snprintf_P(clientId, sizeof(clientId), PSTR("anviz-%08X"), deviceId);
+  mqttTopic(statusTopic, sizeof(statusTopic), "status");
+  mqttTopic(commandTopic, sizeof(commandTopic), "cmd/#");
+
+  if (!connectOutbound(mqttNetClient, mqttTarget, mqttConfig.host, mqttConfig.port, MQTT_CONNECT_TIMEOUT)) {
+    return false;
+  }
+  mqttClient.setServer(mqttTarget.address, mqttConfig.port);
+  mqttClient.setCallback(mqttCallback);
+  mqttClient.setSocketTimeout(MQTT_SOCKET_TIMEOUT);
+  bool connected = mqttClient.connect(clientId,
+                                      mqttConfig.user[0] ? mqttConfig.user : nullptr,
+                                      mqttConfig.user[0] ? mqttConfig.pass : nullptr,
+                                      statusTopic, 0, true, "offline");
+  if (!connected) {
+    mqttNetClient.stop();
+    return false;
+  }
+
+  mqttClient.publish(statusTopic, "online", true);
+  mqttClient.subscribe(commandTopic);
+  metrics.mqttReconnects++;
+  return true;
+}
+
+// Llamar en cada iteración del loop
+void pumpMqtt() {
+  if (!mqttConfig.enabled || mqttConfig.host[0] == 0) return;
+
+  // Cambios remotos de usuarios: persistir una vez pasado el último
+  if (mqttUsersDirty && millis() - mqttUsersChangedAt > MQTT_USERS_SAVE_DELAY) {
+    mqttUsersDirty = false;
+    saveUsers();
+  }
+
+  // Eventos recientes: publicar ya si hay conexión y nada pendiente delante
+  // (para mantener el orden); si no, a la cola de flash
+  if (mqttRamCount > 0) {
+    if (!mqttQueueHasEvents && mqttClient.connected()) mqttPublishRamQueue();
+    if (mqttRamCount > 0) mqttStoreRamQueue();
+  }
+
+  if (!mqttClient.connected()) {
+    if (WiFi.status() != WL_CONNECTED || (long)(millis() - mqttRetryAt) < 0) return;
+    if (!mqttConnect()) {
+      mqttRetryAt = millis() + mqttRetryDelay;
+      mqttRetryDelay = (mqttRetryDelay * 2 > MQTT_RECONNECT_MAX) ? MQTT_RECONNECT_MAX : mqttRetryDelay * 2;
+      return;
+    }
+    mqttRetryDelay = MQTT_RECONNECT_MIN;
+    mqttPublishHeartbeat();
+    mqttLastHeartbeat = millis();
+  }
+
+  mqttClient.loop();
+
+  if (mqttQueueHasEvents) {
+    mqttDrainQueue();
+  }
+
+  if (millis() - mqttLastHeartbeat > MQTT_HEARTBEAT_INTERVAL) {
+    mqttLastHeartbeat = millis();
+    mqttPublishHeartbeat();
+  }
+}
+
+#endif // MQTT_H
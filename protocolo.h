@@ -8,10 +8,18 @@
 
 // Declaración de funciones
 void handleForcedUnlock();
+bool triggerForcedUnlock();
 void handleGetDeviceInfo();
 void handleGetRecordInfo();
 void handleDownloadRecords(uint8_t* data, uint16_t dataLen);
 void handleDownloadStaffInfo(uint8_t* data, uint16_t dataLen);
+int sendRecordPage(int slot, uint8_t requestedCount);
+void sendStaffPage(int startIndex, int count);
+uint8_t bulkPageCount(uint32_t available, uint8_t pageSize);
+void startBulkStream(uint8_t cmd, uint8_t pageSize, uint32_t position, uint8_t pages);
+void noteBulkFrame(uint32_t position);
+int bulkFramesFollowing();
+void cancelBulkStream();
 void handleUploadStaffInfo(uint8_t* data, uint16_t dataLen);
 void handleDeleteUser(uint8_t* data, uint16_t dataLen);
 void handleGetDeviceId();
@@ -26,6 +34,11 @@ void sendSimpleResponse(uint8_t cmd, uint8_t ret);
 void handleGetDeviceTypeCode();
 void handleUploadStaffInfoExtended(uint8_t* data, uint16_t dataLen);
 uint16_t calculateCRC16(uint8_t* data, int length);
+void encodeWireUser(uint8_t* out, const User& user);
+void handleDownloadUserChanges(uint8_t* data, uint16_t dataLen);
+
+// Funciones externas de otros módulos
+extern void emitAccessEvent(const AccessEvent& event);
 
 // Funciones externas del módulo de almacenamiento
 extern void saveConfig();
@@ -40,6 +53,7 @@ extern unsigned long actionStartTime;
 void processAnvizCommand() {
   uint8_t buffer[512];
   int bytesRead = 0;
+  MemProfileScope memScope(MEM_OP_SYNC);
   
   // Leer el encabezado (8 bytes)
   while (client.available() && bytesRead < 8) {
@@ -49,6 +63,7 @@ void processAnvizCommand() {
   // Verificar STX
   if (buffer[0] != STX) {
     Serial.println("Error: STX incorrecto");
+    metrics.frameStxErrors++;
     return;
   }
   
@@ -74,6 +89,7 @@ void processAnvizCommand() {
   // Verificar si recibimos todos los datos esperados
   if (bytesRead != 8 + expectedBytes) {
     Serial.println("Error: Datos incompletos");
+    metrics.frameIncomplete++;
     return;
   }
   
@@ -96,11 +112,18 @@ Serial.println(calculatedCRC, HEX);
 
 if (receivedCRC != calculatedCRC) {
   Serial.println("Error: CRC incorrecto");
+  metrics.frameCrcErrors++;
   return;
 }
+
+  // Un comando nuevo confirma que llegó la respuesta anterior (descargas.h)
+  // y termina una respuesta masiva que siguiera en curso
+  confirmDownloadInFlight();
+  cancelBulkStream();
   
   Serial.print("Comando recibido: 0x");
   Serial.println(cmd, HEX);
+  metrics.commandCounts[cmd & 0x7F]++;
   
   // Procesar comandos específicos
   switch (cmd) {
@@ -158,6 +181,11 @@ if (receivedCRC != calculatedCRC) {
       handleUploadStaffInfoExtended(&buffer[8], dataLen);
       break;
       
+    // Extensiones propias (no existen en los equipos Anviz)
+    case 0x6E: // Descargar cambios de personal desde una versión
+      handleDownloadUserChanges(&buffer[8], dataLen);
+      break;
+      
     default:
       // Comando no soportado
       Serial.print("Comando no soportado: 0x");
@@ -228,7 +256,7 @@ void handleGetDeviceInfo() {
   response[28] = crc & 0xFF;
   
   // Enviar respuesta
-  client.write(response, 29);
+  sessionSend(response, 29);
 }
 
 // CMD 0x3C: Obtener información de registros
@@ -275,10 +303,12 @@ void handleGetRecordInfo() {
   response[19] = 0;
   response[20] = userCount; // Asumimos que cada usuario tiene una tarjeta
   
-  // All Record Amount (3 bytes)
-  response[21] = (recordCount >> 16) & 0xFF;
-  response[22] = (recordCount >> 8) & 0xFF;
-  response[23] = recordCount & 0xFF;
+  // All Record Amount (3 bytes): los registros guardados, no la secuencia
+  // (que sigue creciendo tras desbordar el anillo o borrar registros)
+  uint32_t storedRecords = storedRecordCount();
+  response[21] = (storedRecords >> 16) & 0xFF;
+  response[22] = (storedRecords >> 8) & 0xFF;
+  response[23] = storedRecords & 0xFF;
   
   // New Record Amount (3 bytes)
   response[24] = (newRecordCount >> 16) & 0xFF;
@@ -291,7 +321,7 @@ void handleGetRecordInfo() {
   response[28] = crc & 0xFF;
   
   // Enviar respuesta
-  client.write(response, 29);
+  sessionSend(response, 29);
 }
 
 // CMD 0x40: Descargar registros de acceso
@@ -301,8 +331,10 @@ void handleDownloadRecords(uint8_t* data, uint16_t dataLen) {
     return;
   }
   
-  // Extraer parámetros
-  uint8_t parameter = data[0];
+  // Extraer parámetros. El bit BULK_REQUEST_FLAG (extensión propia) pide la
+  // respuesta masiva; CrossChex nunca lo pone.
+  bool bulkRequested = data[0] & BULK_REQUEST_FLAG;
+  uint8_t parameter = data[0] & ~BULK_REQUEST_FLAG;
   uint8_t requestedCount = data[1];
   
   // Limitar a 25 registros por solicitud como indica el protocolo
@@ -310,38 +342,56 @@ void handleDownloadRecords(uint8_t* data, uint16_t dataLen) {
     requestedCount = 25;
   }
   
-  // Determinar qué registros enviar
-  int startIndex = 0;
-  int count = 0;
-  
+  // Determinar desde qué secuencia enviar. Cada cliente tiene su cursor
+  // (descargas.h): el parámetro 0 continúa desde el último lote enviado y el
+  // 2 retoma desde lo último que el cliente confirmó.
+  if (parameter > 2) {
+    // Parámetro no soportado: respuesta vacía pero exitosa
+    sendSimpleResponse(0x40, ACK_SUCCESS);
+    return;
+  }
+  int slot = downloadCursorForClient();
+  DownloadCursor& cursor = downloadCursors[slot];
   if (parameter == 1) {
     // Reiniciar y enviar todos los registros
-    lastDownloadRecordIndex = 0;
-    startIndex = 0;
-    count = (requestedCount < recordCount) ? requestedCount : recordCount;
+    cursor.sent = firstRecordSeq();
   } else if (parameter == 2) {
-    // Reiniciar y enviar nuevos registros
-    lastDownloadRecordIndex = (recordCount > newRecordCount) ? (recordCount - newRecordCount) : 0;
-    startIndex = lastDownloadRecordIndex;
-    count = (requestedCount < newRecordCount) ? requestedCount : newRecordCount;
-  } else if (parameter == 0) {
-    // Continuar descarga normal
-    startIndex = lastDownloadRecordIndex;
-    count = (requestedCount < (recordCount - lastDownloadRecordIndex)) ? 
-            requestedCount : (recordCount - lastDownloadRecordIndex);
-    lastDownloadRecordIndex += count;
+    // Enviar los registros nuevos para este cliente
+    cursor.sent = cursor.acked;
   }
   
-  // Si no hay registros para enviar, envía una respuesta vacía pero exitosa.
-  if (count == 0) {
-    sendSimpleResponse(0x40, ACK_SUCCESS);
-    return;
+  // En modo masivo, las tramas siguientes salen desde pumpBulkStream()
+  if (bulkRequested) {
+    startBulkStream(0x40, requestedCount, slot, bulkPageCount(recordCount - cursor.sent, requestedCount));
   }
+  sendRecordPage(slot, requestedCount);
+}
+
+// Enviar una trama 0xC0 con hasta requestedCount registros desde el cursor.
+// Devuelve los registros enviados (0: respuesta vacía).
+int sendRecordPage(int slot, uint8_t requestedCount) {
+  DownloadCursor& cursor = downloadCursors[slot];
+  noteBulkFrame(cursor.sent);
+  int following = bulkFramesFollowing();
   
   // Preparar respuesta
   // Usar un buffer estático para evitar la asignación dinámica y posible fragmentación.
-  // El tamaño máximo es 12 bytes de cabecera + 25 registros * 14 bytes/registro = 362 bytes.
-  uint8_t response[12 + 25 * 14];
+  // El tamaño máximo es 12 bytes de cabecera + 25 registros * 14 bytes/registro
+  // + 1 byte de tramas siguientes en modo masivo = 363 bytes.
+  uint8_t response[12 + 25 * 14 + 1];
+  
+  // Records data: el almacén ya tiene el formato de la trama (registros.h)
+  uint32_t available = recordCount - cursor.sent;
+  int count = (available < requestedCount) ? available : requestedCount;
+  copyWireRecords(&response[10], cursor.sent, count);
+  
+  // Si no hay registros para enviar, envía una respuesta vacía pero exitosa.
+  // En modo masivo la trama vacía lleva igualmente el contador de tramas.
+  if (count == 0 && following < 0) {
+    sendSimpleResponse(0x40, ACK_SUCCESS);
+    return 0;
+  }
+  
   // STX
   response[0] = STX;
   
@@ -358,40 +408,15 @@ void handleDownloadRecords(uint8_t* data, uint16_t dataLen) {
   response[6] = ACK_SUCCESS;
   
   // LEN
-  uint16_t responseLen = 1 + count * 14; // Cada registro ocupa 14 bytes
+  uint16_t responseLen = 1 + count * 14 + (following >= 0 ? 1 : 0); // Cada registro ocupa 14 bytes
   response[7] = (responseLen >> 8) & 0xFF;
   response[8] = responseLen & 0xFF;
   
   // DATA
   // Valid records count
   response[9] = count;
-  
-  // Records data
-  for (int i = 0; i < count; i++) {
-    int idx = startIndex + i;
-    int recordOffset = 10 + i * 14;
-
-    // User ID (5 bytes)
-    memcpy(&response[recordOffset], records[idx].id, 5);
-    
-    // Date & Time (4 bytes)
-    uint32_t timestamp = records[idx].timestamp;
-    // Attempt to correct the "one day extra" issue by subtracting one day (24 hours)
-    // This assumes CrossChex is incorrectly adding a day.
-    timestamp -= (24 * 3600); // Subtract 24 hours in seconds
-    response[recordOffset + 5] = (timestamp >> 24) & 0xFF;
-    response[recordOffset + 6] = (timestamp >> 16) & 0xFF;
-    response[recordOffset + 7] = (timestamp >> 8) & 0xFF;
-    response[recordOffset + 8] = timestamp & 0xFF;
-    
-    // Backup code (1 byte)
-    response[recordOffset + 9] = records[idx].backup;
-    
-    // Record type (1 byte)
-    response[recordOffset + 10] = records[idx].recordType;
-    
-    // Work code (3 bytes)
-    memcpy(&response[recordOffset + 11], records[idx].workCode, 3);
+  if (following >= 0) {
+    response[10 + count * 14] = following;
   }
   
   // Calcular CRC16
@@ -399,14 +424,14 @@ void handleDownloadRecords(uint8_t* data, uint16_t dataLen) {
   response[9 + responseLen] = (crc >> 8) & 0xFF;
   response[9 + responseLen + 1] = crc & 0xFF;
   
-  // Enviar respuesta
-  client.write(response, 9 + responseLen + 2);
-  
-  // Si hemos enviado registros nuevos, actualizamos el contador
-  if (parameter == 2 && count > 0) {
-    newRecordCount = 0;
-    saveRecords();
+  // Enviar respuesta. El lote queda en vuelo hasta que sale de la cola y
+  // llega el siguiente comando de esta conexión (descargas.h).
+  if (!sessionSend(response, 9 + responseLen + 2)) return 0;
+  if (count > 0) {
+    cursor.sent += count;
+    noteDownloadFrame(slot, txQueuedTotal, cursor.sent);
   }
+  return count;
 }
 
 // CMD 0x42: Descargar información de personal
@@ -416,8 +441,9 @@ void handleDownloadStaffInfo(uint8_t* data, uint16_t dataLen) {
     return;
   }
   
-  // Extraer parámetros
-  uint8_t parameter = data[0];
+  // Extraer parámetros (BULK_REQUEST_FLAG como en 0x40)
+  bool bulkRequested = data[0] & BULK_REQUEST_FLAG;
+  uint8_t parameter = data[0] & ~BULK_REQUEST_FLAG;
   uint8_t requestedCount = data[1];
   
   // Limitar a 12 usuarios por solicitud como indica el protocolo
@@ -447,10 +473,23 @@ void handleDownloadStaffInfo(uint8_t* data, uint16_t dataLen) {
     }
   }
   
+  // En modo masivo, las tramas siguientes salen desde pumpBulkStream()
+  if (bulkRequested) {
+    startBulkStream(0x42, requestedCount, startIndex + count, bulkPageCount(count > 0 ? userCount - startIndex : 0, requestedCount));
+  }
+  sendStaffPage(startIndex, count);
+}
+
+// Enviar una trama 0xC2 con count usuarios desde startIndex
+void sendStaffPage(int startIndex, int count) {
+  noteBulkFrame(startIndex);
+  int following = bulkFramesFollowing();
+  
   // Preparar respuesta
   // Usar un buffer estático para evitar la asignación dinámica y posible fragmentación.
-  // El tamaño máximo es 12 bytes de cabecera + 12 usuarios * 27 bytes/usuario = 336 bytes.
-  uint8_t response[12 + 12 * 27];
+  // El tamaño máximo es 12 bytes de cabecera + 12 usuarios * 27 bytes/usuario
+  // + 1 byte de tramas siguientes en modo masivo = 337 bytes.
+  uint8_t response[12 + 12 * 27 + 1];
   
   // STX
   response[0] = STX;
@@ -469,7 +508,7 @@ void handleDownloadStaffInfo(uint8_t* data, uint16_t dataLen) {
   response[6] = ACK_SUCCESS;
   
   // LEN
-  uint16_t responseLen = 1 + count * 27;
+  uint16_t responseLen = 1 + count * 27 + (following >= 0 ? 1 : 0);
   response[7] = (responseLen >> 8) & 0xFF;
   response[8] = responseLen & 0xFF;
   
@@ -479,37 +518,10 @@ void handleDownloadStaffInfo(uint8_t* data, uint16_t dataLen) {
   
   // Users data
   for (int i = 0; i < count; i++) {
-    int idx = startIndex + i;
-    
-    // User ID (5 bytes)
-    memcpy(&response[10 + i*27], users[idx].id, 5);
-    
-    // Password (3 bytes)
-    memcpy(&response[10 + i*27 + 5], users[idx].password, 3);
-    
-    // Card ID (3 bytes)
-    uint32_t cardId = users[idx].cardId;
-    response[10 + i*27 + 8] = (cardId >> 16) & 0xFF;
-    response[10 + i*27 + 9] = (cardId >> 8) & 0xFF;
-    response[10 + i*27 + 10] = cardId & 0xFF;
-    
-    // Name (10 bytes)
-    memcpy(&response[10 + i*27 + 11], users[idx].name, 10);
-    
-    // Department (1 byte)
-    response[10 + i*27 + 21] = users[idx].department;
-    
-    // Group (1 byte)
-    response[10 + i*27 + 22] = users[idx].group;
-    
-    // Attendance mode (1 byte)
-    response[10 + i*27 + 23] = users[idx].mode;
-    
-    // FP Status (2 bytes)
-    memcpy(&response[10 + i*27 + 24], users[idx].fpStatus, 2);
-    
-    // Special info (1 byte)
-    response[10 + i*27 + 26] = users[idx].special;
+    encodeWireUser(&response[10 + i*27], users[startIndex + i]);
+  }
+  if (following >= 0) {
+    response[10 + count * 27] = following;
   }
   
   // Calcular CRC16
@@ -518,7 +530,7 @@ void handleDownloadStaffInfo(uint8_t* data, uint16_t dataLen) {
   response[9 + responseLen + 1] = crc & 0xFF;
   
   // Enviar respuesta
-  client.write(response, 12 + count * 27);
+  sessionSend(response, 9 + responseLen + 2);
 }
 
 // CMD 0x43: Cargar información de personal
@@ -543,14 +555,11 @@ void handleUploadStaffInfo(uint8_t* data, uint16_t dataLen) {
   for (int i = 0; i < count; i++) {
     uint8_t* userData = &data[1 + i*27];
     
+    // Los IDs reservados para los rangos de tarjetas no se admiten (fallo)
+    if (isCardRangeRecordId(userData)) continue;
+    
     // Buscar si el usuario ya existe por ID
-    int existingIndex = -1;
-    for (int j = 0; j < userCount; j++) {
-      if (memcmp(users[j].id, userData, 5) == 0) {
-        existingIndex = j;
-        break;
-      }
-    }
+    int existingIndex = indexFindUserById(userData);
     
     if (existingIndex >= 0) {
       // Actualizar usuario existente
@@ -570,10 +579,12 @@ void handleUploadStaffInfo(uint8_t* data, uint16_t dataLen) {
       memcpy(users[existingIndex].fpStatus, &userData[24], 2);
       users[existingIndex].special = userData[26];
       users[existingIndex].isActive = true;
+      users[existingIndex].version = noteUserChange(userData, USER_CHANGE_UPDATE);
+      invalidateUserIndex();
       
       // Marcar como exitoso
       result |= (1 << i);
-    } else if (userCount < 100) {
+    } else if (userCount < MAX_USERS) {
       // Añadir nuevo usuario
       User newUser;
       
@@ -594,9 +605,11 @@ void handleUploadStaffInfo(uint8_t* data, uint16_t dataLen) {
       memcpy(newUser.fpStatus, &userData[24], 2);
       newUser.special = userData[26];
       newUser.isActive = true;
+      newUser.version = noteUserChange(userData, USER_CHANGE_ADD);
       
       // Añadir a la lista
       users[userCount++] = newUser;
+      invalidateUserIndex();
       
       // Marcar como exitoso
       result |= (1 << i);
@@ -638,7 +651,7 @@ void handleUploadStaffInfo(uint8_t* data, uint16_t dataLen) {
   response[12] = crc & 0xFF;
   
   // Enviar respuesta
-  client.write(response, 13);
+  sessionSend(response, 13);
 }
 
 // CMD 0x4C: Eliminar datos de usuario
@@ -654,13 +667,7 @@ void handleDeleteUser(uint8_t* data, uint16_t dataLen) {
   uint8_t backupCode = data[5];
   
   // Buscar usuario por ID
-  int userIndex = -1;
-  for (int i = 0; i < userCount; i++) {
-    if (memcmp(users[i].id, userId, 5) == 0) {
-      userIndex = i;
-      break;
-    }
-  }
+  int userIndex = indexFindUserById(userId);
   
   if (userIndex < 0) {
     // Usuario no encontrado
@@ -676,15 +683,21 @@ void handleDeleteUser(uint8_t* data, uint16_t dataLen) {
       users[i] = users[i + 1];
     }
     userCount--;
+    noteUserChange(userId, USER_CHANGE_DELETE);
+    invalidateUserIndex();
   } else {
     // Borrar selectivamente
     if (backupCode & 0x08) { // Borrar tarjeta
       users[userIndex].cardId = 0;
+      invalidateUserIndex();
     }
     if (backupCode & 0x04) { // Borrar contraseña
       memset(users[userIndex].password, 0xFF, 3);
     }
     // No implementamos borrado de huellas digitales porque no las usamos
+    if (backupCode & 0x0C) {
+      users[userIndex].version = noteUserChange(userId, USER_CHANGE_UPDATE);
+    }
   }
   
   // Guardar usuarios
@@ -694,6 +707,114 @@ void handleDeleteUser(uint8_t* data, uint16_t dataLen) {
   sendSimpleResponse(0x4C, ACK_SUCCESS);
 }
 
+// ========= MODO MASIVO (0x40 / 0x42) ===========
+// Extensión propia para middleware, que no existe en los equipos Anviz ni la
+// entiende ninguna versión de CrossChex. Solo se activa cuando la petición
+// lleva BULK_REQUEST_FLAG en el parámetro; sin él la respuesta es siempre
+// la trama estricta del protocolo.
+// Una petición masiva se responde con varias tramas seguidas, cada una del
+// tamaño pedido (como mucho 25 registros o 12 usuarios) y continuando desde
+// el mismo cursor: las que hacen falta para lo pendiente al recibir la
+// petición, hasta basicConfig.bulkPages. Cada trama lleva al final de DATA
+// un byte más con el número de tramas que la siguen (0 en la última), así
+// que la primera anuncia la respuesta completa; el cliente pide entonces la
+// siguiente tanda. Las tramas después
+// de la primera se generan desde el loop a medida que la cola de transmisión
+// tiene hueco (sesion.h), así que no hace falta memoria extra.
+// Un comando nuevo termina la respuesta y retira de la cola las tramas que
+// aún no han empezado a salir, para que no se mezclen con su respuesta.
+
+typedef struct {
+  uint8_t cmd;          // 0x40 o 0x42 (0 = ninguna respuesta masiva)
+  uint8_t pagesLeft;    // Tramas que faltan por generar
+  uint8_t pageSize;     // Registros o usuarios por trama
+  uint32_t position;    // 0x40: cursor de descarga; 0x42: índice del siguiente usuario
+  uint32_t session;     // Sesión para la que se generan (metrics.sessionsOpened)
+  uint8_t frameCount;   // Tramas ya encoladas
+  uint32_t frameStart[BULK_MAX_PAGES]; // Posición de cada trama en el flujo TCP
+  uint32_t framePos[BULK_MAX_PAGES];   // Secuencia o índice de usuario con que empieza
+} BulkStream;
+
+BulkStream bulkStream;
+
+// Tramas de una respuesta masiva: las que hacen falta para available
+// registros o usuarios, hasta bulkPages (al menos una)
+uint8_t bulkPageCount(uint32_t available, uint8_t pageSize) {
+  if (basicConfig.bulkPages <= 1 || pageSize == 0) return 1;
+  uint32_t pages = (available + pageSize - 1) / pageSize;
+  if (pages < 1) pages = 1;
+  if (pages > basicConfig.bulkPages) pages = basicConfig.bulkPages;
+  return pages;
+}
+
+// Llamar antes de enviar la primera trama de una petición masiva
+void startBulkStream(uint8_t cmd, uint8_t pageSize, uint32_t position, uint8_t pages) {
+  bulkStream.cmd = cmd;
+  bulkStream.frameCount = 0;
+  bulkStream.pagesLeft = pages - 1;
+  bulkStream.pageSize = pageSize;
+  bulkStream.position = position;
+  bulkStream.session = metrics.sessionsOpened;
+}
+
+// Anotar dónde empieza en el flujo la trama que se va a encolar
+void noteBulkFrame(uint32_t position) {
+  if (bulkStream.cmd == 0 || bulkStream.frameCount >= BULK_MAX_PAGES) return;
+  bulkStream.frameStart[bulkStream.frameCount] = txQueuedTotal;
+  bulkStream.framePos[bulkStream.frameCount] = position;
+  bulkStream.frameCount++;
+}
+
+// Tramas que siguen a la que se va a enviar (-1: modo estricto, sin contador)
+int bulkFramesFollowing() {
+  return (bulkStream.cmd != 0) ? bulkStream.pagesLeft : -1;
+}
+
+// Llamar al recibir un comando: retira de la cola las tramas de la respuesta
+// masiva que aún no han empezado a salir y devuelve el cursor a la primera
+void cancelBulkStream() {
+  if (bulkStream.cmd != 0 && sessionActive && bulkStream.session == metrics.sessionsOpened) {
+    for (int i = 0; i < bulkStream.frameCount; i++) {
+      if (!sessionDropQueuedFrom(bulkStream.frameStart[i])) continue;
+      if (bulkStream.cmd == 0x40) {
+        rewindDownloadInFlight(bulkStream.frameStart[i], bulkStream.framePos[i]);
+      } else {
+        lastDownloadUserIndex = bulkStream.framePos[i];
+      }
+      break;
+    }
+  }
+  bulkStream.cmd = 0;
+  bulkStream.frameCount = 0;
+}
+
+// Llamar en cada iteración del loop
+void pumpBulkStream() {
+  if (bulkStream.cmd == 0 || bulkStream.pagesLeft == 0) return;
+  if (!sessionActive || bulkStream.session != metrics.sessionsOpened) {
+    // La sesión para la que se generaba ya no existe
+    bulkStream.cmd = 0;
+    bulkStream.frameCount = 0;
+    return;
+  }
+
+  // Se envían exactamente las tramas anunciadas, aunque alguna salga
+  // incompleta o vacía (registros borrados o usuarios eliminados entretanto)
+  while (bulkStream.pagesLeft > 0 && sessionCanAccept()) {
+    bulkStream.pagesLeft--;
+    if (bulkStream.cmd == 0x40) {
+      sendRecordPage(bulkStream.position, bulkStream.pageSize);
+    } else {
+      int startIndex = bulkStream.position;
+      int count = (userCount - startIndex < bulkStream.pageSize) ? userCount - startIndex : bulkStream.pageSize;
+      if (count < 0) count = 0;
+      sendStaffPage(startIndex, count);
+      bulkStream.position += count;
+      lastDownloadUserIndex = (bulkStream.position >= (uint32_t)userCount) ? 0 : bulkStream.position;
+    }
+  }
+}
+
 // CMD 0x74: Obtener ID del dispositivo
 void handleGetDeviceId() {
   uint8_t response[15];
@@ -729,7 +850,7 @@ void handleGetDeviceId() {
   response[14] = crc & 0xFF;
   
   // Enviar respuesta
-  client.write(response, 15);
+  sessionSend(response, 15);
 }
 
 // CMD 0x31: Configurar información de T&A 1
@@ -797,7 +918,7 @@ void handleGetTime() {
   response[15] = crc & 0xFF;
   
   // Enviar respuesta
-  client.write(response, 16);
+  sessionSend(response, 16);
 }
 
 // CMD 0x39: Configurar fecha y hora
@@ -837,37 +958,12 @@ void handleUploadRecord(uint8_t* data, uint16_t dataLen) {
   
   // Procesar cada registro
   for (int i = 0; i < count; i++) {
-    if (recordCount >= 500) {
-      // Buffer lleno, sobrescribir el más antiguo
-      for (int j = 0; j < 499; j++) {
-        records[j] = records[j+1];
-      }
-      recordCount = 499;
-    }
-    
+    // ID, hora, backup, tipo y código de trabajo: mismo formato que AccessRecord
     AccessRecord record;
+    memcpy(&record, &data[1 + i*14], sizeof(AccessRecord));
     
-    // Copiar ID de usuario (5 bytes)
-    memcpy(record.id, &data[1 + i*14], 5);
-    
-    // Copiar timestamp (4 bytes)
-    record.timestamp = ((uint32_t)data[1 + i*14 + 5] << 24) | 
-                       ((uint32_t)data[1 + i*14 + 6] << 16) |
-                       ((uint32_t)data[1 + i*14 + 7] << 8) |
-                       data[1 + i*14 + 8];
-    
-    // Backup code (1 byte)
-    record.backup = data[1 + i*14 + 9];
-    
-    // Record type (1 byte)
-    record.recordType = data[1 + i*14 + 10];
-    
-    // Work code (3 bytes)
-    memcpy(record.workCode, &data[1 + i*14 + 11], 3);
-    
-    // Añadir registro
-    records[recordCount++] = record;
-    newRecordCount++;
+    // Añadir registro al almacén (sobrescribe el más antiguo si está lleno)
+    appendRecord(record);
   }
   
   // Guardar registros
@@ -888,11 +984,13 @@ void handleDeleteRecords(uint8_t* data, uint16_t dataLen) {
   
   if (parameter == 1) {
     // Borrar todos los registros
-    recordCount = 0;
-    newRecordCount = 0;
+    clearRecords();
   } else if (parameter == 2) {
-    // Borrar marca de nuevos registros
+    // Borrar marca de nuevos registros: el cliente da por recibido todo
     newRecordCount = 0;
+    DownloadCursor& cursor = downloadCursors[downloadCursorForClient()];
+    cursor.sent = recordCount;
+    acknowledgeDownload(cursor, recordCount);
   }
   
   // Guardar cambios
@@ -904,17 +1002,28 @@ void handleDeleteRecords(uint8_t* data, uint16_t dataLen) {
 
 // CMD 0x5E: Abrir cerradura sin verificar usuario
 void handleForcedUnlock() {
-  // Solo procesar si no hay otra acción en curso
-  if (currentLedState == LED_IDLE) {
-    // Iniciar estado de apertura forzada (no bloqueante)
-    currentLedState = LED_FORCED_UNLOCK;
-    actionStartTime = millis();
-    digitalWrite(basicConfig.pin_relay, HIGH);
-    digitalWrite(basicConfig.pin_led, HIGH);
-  }
+  triggerForcedUnlock();
   sendSimpleResponse(0x5E, ACK_SUCCESS); // Enviar respuesta inmediatamente
 }
 
+// Apertura forzada desde CrossChex o MQTT. Devuelve false si hay otra acción en curso.
+bool triggerForcedUnlock() {
+  // Solo procesar si no hay otra acción en curso
+  if (currentLedState != LED_IDLE) return false;
+
+  // Iniciar estado de apertura forzada (no bloqueante)
+  currentLedState = LED_FORCED_UNLOCK;
+  actionStartTime = millis();
+  digitalWrite(basicConfig.pin_relay, HIGH);
+  digitalWrite(basicConfig.pin_led, HIGH);
+
+  AccessEvent event = {0};
+  event.timestamp = now() - 946684800;
+  event.kind = EVENT_FORCED_UNLOCK;
+  emitAccessEvent(event);
+  return true;
+}
+
 // CMD 0x75: Modificar ID de dispositivo de comunicación
 void handleSetDeviceId(uint8_t* data, uint16_t dataLen) {
   if (dataLen < 4) {
@@ -964,14 +1073,11 @@ void handleUploadStaffInfoExtended(uint8_t* data, uint16_t dataLen) {
     for (int i = 0; i < count; i++) {
         uint8_t* userData = &data[1 + i*30];
         
+        // Los IDs reservados para los rangos de tarjetas no se admiten (fallo)
+        if (isCardRangeRecordId(userData)) continue;
+        
         // Buscar si el usuario ya existe por ID
-        int existingIndex = -1;
-        for (int j = 0; j < userCount; j++) {
-            if (memcmp(users[j].id, userData, 5) == 0) {
-                existingIndex = j;
-                break;
-            }
-        }
+        int existingIndex = indexFindUserById(userData);
         
         if (existingIndex >= 0) {
             // Actualizar usuario existente
@@ -1002,11 +1108,13 @@ void handleUploadStaffInfoExtended(uint8_t* data, uint16_t dataLen) {
             
             users[existingIndex].special = userData[27];
             users[existingIndex].isActive = true;
+            users[existingIndex].version = noteUserChange(userData, USER_CHANGE_UPDATE);
+            invalidateUserIndex();
             
             // Marcar como exitoso
             result |= (1 << i);
         } 
-        else if (userCount < 100) {
+        else if (userCount < MAX_USERS) {
             // Añadir nuevo usuario
             User newUser = {0}; // Inicializar a cero
             
@@ -1033,9 +1141,11 @@ void handleUploadStaffInfoExtended(uint8_t* data, uint16_t dataLen) {
             memcpy(newUser.fpStatus, &userData[25], 2);
             newUser.special = userData[27];
             newUser.isActive = true;
+            newUser.version = noteUserChange(userData, USER_CHANGE_ADD);
             
             // Añadir a la lista
             users[userCount++] = newUser;
+            invalidateUserIndex();
             
             // Marcar como exitoso
             result |= (1 << i);
@@ -1077,12 +1187,120 @@ void handleUploadStaffInfoExtended(uint8_t* data, uint16_t dataLen) {
     response[12] = crc & 0xFF;
     
     // Enviar respuesta
-    client.write(response, 13);
+    sessionSend(response, 13);
     
     Serial.print("Carga de usuarios completada. Total usuarios: ");
     Serial.println(userCount);
 }
 
+// CMD 0x6E (extensión propia): Descargar cambios de personal desde una versión
+// Petición: versión conocida por el cliente (4 bytes).
+// Respuesta: versión actual (4 bytes), indicadores (1 byte, bit 0 = hay que
+// volver a descargar la tabla con 0x42), número de cambios (1 byte) y hasta
+// 12 cambios de 32 bytes: versión (4), operación (1: 0 alta, 1 modificación,
+// 2 baja) y el usuario en el formato de 0x42 (27; en las bajas solo el ID).
+// El cliente repite la petición con la versión del último cambio recibido
+// hasta que llegue una respuesta sin cambios.
+void handleDownloadUserChanges(uint8_t* data, uint16_t dataLen) {
+  if (dataLen < 4) {
+    sendSimpleResponse(0x6E, ACK_FAIL);
+    return;
+  }
+  
+  uint32_t since = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+                   ((uint32_t)data[2] << 8) | data[3];
+  bool resync = !userJournalCovers(since);
+  
+  uint8_t response[17 + 12 * 32];
+  
+  // STX
+  response[0] = STX;
+  
+  // CH (Device ID)
+  response[1] = (deviceId >> 24) & 0xFF;
+  response[2] = (deviceId >> 16) & 0xFF;
+  response[3] = (deviceId >> 8) & 0xFF;
+  response[4] = deviceId & 0xFF;
+  
+  // ACK
+  response[5] = 0xEE; // CMD (0x6E) + 0x80
+  
+  // RET
+  response[6] = ACK_SUCCESS;
+  
+  // DATA
+  response[9] = (userVersion >> 24) & 0xFF;
+  response[10] = (userVersion >> 16) & 0xFF;
+  response[11] = (userVersion >> 8) & 0xFF;
+  response[12] = userVersion & 0xFF;
+  response[13] = resync ? 0x01 : 0x00;
+  
+  uint8_t count = 0;
+  if (!resync) {
+    for (uint32_t pos = userJournalFind(since); pos < userJournalCount && count < 12; pos++) {
+      const UserChange& change = userJournal[pos % USER_JOURNAL_SIZE];
+      uint8_t* entry = &response[15 + count * 32];
+      entry[0] = (change.version >> 24) & 0xFF;
+      entry[1] = (change.version >> 16) & 0xFF;
+      entry[2] = (change.version >> 8) & 0xFF;
+      entry[3] = change.version & 0xFF;
+      entry[4] = change.op;
+      
+      // Estado actual del usuario; si ya no existe se envía solo el ID
+      int userIndex = (change.op == USER_CHANGE_DELETE) ? -1 : indexFindUserById(change.id);
+      if (userIndex >= 0) {
+        encodeWireUser(&entry[5], users[userIndex]);
+      } else {
+        memset(&entry[5], 0, 27);
+        memcpy(&entry[5], change.id, 5);
+      }
+      count++;
+    }
+  }
+  response[14] = count;
+  
+  // LEN
+  uint16_t responseLen = 6 + count * 32;
+  response[7] = (responseLen >> 8) & 0xFF;
+  response[8] = responseLen & 0xFF;
+  
+  // Calcular CRC16
+  uint16_t crc = calculateCRC16(response, 9 + responseLen);
+  response[9 + responseLen] = (crc >> 8) & 0xFF;
+  response[9 + responseLen + 1] = crc & 0xFF;
+  
+  // Enviar respuesta
+  sessionSend(response, 11 + responseLen);
+}
+
+// Codificar un usuario en el formato de 27 bytes del protocolo (0x42)
+void encodeWireUser(uint8_t* out, const User& user) {
+  // User ID (5 bytes)
+  memcpy(&out[0], user.id, 5);
+  
+  // Password (3 bytes)
+  memcpy(&out[5], user.password, 3);
+  
+  // Card ID (3 bytes)
+  out[8] = (user.cardId >> 16) & 0xFF;
+  out[9] = (user.cardId >> 8) & 0xFF;
+  out[10] = user.cardId & 0xFF;
+  
+  // Name (10 bytes)
+  memcpy(&out[11], user.name, 10);
+  
+  // Department, group, attendance mode (1 byte cada uno)
+  out[21] = user.department;
+  out[22] = user.group;
+  out[23] = user.mode;
+  
+  // FP Status (2 bytes)
+  memcpy(&out[24], user.fpStatus, 2);
+  
+  // Special info (1 byte)
+  out[26] = user.special;
+}
+
 // Función genérica para enviar respuestas simples
 void sendSimpleResponse(uint8_t cmd, uint8_t ret) {
   uint8_t response[11];
@@ -1112,7 +1330,7 @@ void sendSimpleResponse(uint8_t cmd, uint8_t ret) {
   response[10] = crc & 0xFF;
   
   // Enviar respuesta
-  client.write(response, 11);
+  sessionSend(response, 11);
 }
 
 // Función para calcular CRC16
@@ -0,0 +1,245 @@
+/**
+ * rangos.h
+ * Lista blanca de rangos de tarjetas consecutivas con un mapa de bits por
+ * rango en SPIFFS, para lotes de tarjetas que no caben en users[]
+ */
+
+#ifndef RANGOS_H
+#define RANGOS_H
+
+#define RANGE_IO_BLOCK 64             // Bytes del mapa de bits por lectura/escritura
+#define RANGE_CACHE_BLOCKS 4          // Bloques del mapa de bits guardados en RAM
+
+CardRange cardRanges[MAX_CARD_RANGES];
+int cardRangeCount = 0;
+
+// Caché de bloques del mapa de bits: una tarjeta de rango que se repite
+// (la misma contrata entrando y saliendo) no vuelve a abrir SPIFFS.
+typedef struct {
+  bool valid;
+  uint8_t file;         // Número de archivo del mapa de bits
+  uint16_t block;       // Posición del bloque en el archivo (en bloques)
+  uint32_t lastUsed;
+  uint8_t data[RANGE_IO_BLOCK];
+} RangeCacheBlock;
+
+RangeCacheBlock rangeCache[RANGE_CACHE_BLOCKS];
+uint32_t rangeCacheClock = 0;
+
+// Olvidar los bloques de un mapa de bits (al modificarlo o borrarlo)
+void invalidateCardRangeCache(uint8_t file) {
+  for (int i = 0; i < RANGE_CACHE_BLOCKS; i++) {
+    if (rangeCache[i].file == file) rangeCache[i].valid = false;
+  }
+}
+
+// Ruta del mapa de bits de un rango
+void cardRangePath(char* buffer, size_t len, uint8_t file) {
+  snprintf_P(buffer, len, PSTR("/range%u.bin"), file);
+}
+
+// Rango que contiene la tarjeta, o -1. Como mucho MAX_CARD_RANGES comparaciones.
+int findCardRange(uint32_t cardId) {
+  for (int i = 0; i < cardRangeCount; i++) {
+    if (cardId - cardRanges[i].firstCard < cardRanges[i].count) return i;
+  }
+  return -1;
+}
+
+// ¿Se solapa [firstCard, firstCard + count - 1] con algún rango existente?
+// Se comparan los extremos inclusivos: un rango que acaba en 0xFFFFFFFF
+// desbordaría el extremo exclusivo a 0.
+bool cardRangeOverlaps(uint32_t firstCard, uint32_t count) {
+  uint32_t lastCard = firstCard + count - 1;
+  for (int i = 0; i < cardRangeCount; i++) {
+    const CardRange& range = cardRanges[i];
+    uint32_t rangeLast = range.firstCard + range.count - 1;
+    if (firstCard <= rangeLast && range.firstCard <= lastCard) return true;
+  }
+  return false;
+}
+
+// Byte del mapa de bits de un rango, desde la caché o leyendo su bloque de
+// SPIFFS (sustituye el bloque usado hace más tiempo). -1 si no se puede leer.
+int cardRangeBitmapByte(const CardRange& range, uint32_t byteIndex) {
+  uint16_t block = byteIndex / RANGE_IO_BLOCK;
+  int victim = 0;
+  for (int i = 0; i < RANGE_CACHE_BLOCKS; i++) {
+    RangeCacheBlock& entry = rangeCache[i];
+    if (entry.valid && entry.file == range.file && entry.block == block) {
+      entry.lastUsed = ++rangeCacheClock;
+      return entry.data[byteIndex % RANGE_IO_BLOCK];
+    }
+    if (!rangeCache[victim].valid) continue;
+    if (!entry.valid || entry.lastUsed < rangeCache[victim].lastUsed) victim = i;
+  }
+
+  char path[16];
+  cardRangePath(path, sizeof(path), range.file);
+  File file = SPIFFS.open(path, "r");
+  if (!file) return -1;
+  RangeCacheBlock& entry = rangeCache[victim];
+  memset(entry.data, 0, sizeof(entry.data));
+  bool ok = file.seek((uint32_t)block * RANGE_IO_BLOCK, SeekSet) && file.read(entry.data, RANGE_IO_BLOCK) > 0;
+  file.close();
+  if (!ok) return -1;
+  entry.valid = true;
+  entry.file = range.file;
+  entry.block = block;
+  entry.lastUsed = ++rangeCacheClock;
+  return entry.data[byteIndex % RANGE_IO_BLOCK];
+}
+
+// Comprobar si una tarjeta está habilitada en algún rango. Se consulta un
+// único byte del mapa de bits (de la caché si su bloque está en RAM), así que
+// el coste no depende del tamaño del rango. Devuelve el rango o -1.
+int cardRangeAllows(uint32_t cardId) {
+  int index = findCardRange(cardId);
+  if (index < 0) return -1;
+
+  const CardRange& range = cardRanges[index];
+  if (range.enabled == 0) return -1;
+  uint32_t bit = cardId - range.firstCard;
+  int value = cardRangeBitmapByte(range, bit >> 3);
+  return (value >= 0 && ((value >> (bit & 7)) & 1)) ? index : -1;
+}
+
+// Máscara de los bits [from, to] (inclusivo, relativos al rango) dentro del byte
+uint8_t cardRangeByteMask(uint32_t byteIndex, uint32_t from, uint32_t to) {
+  uint32_t first = byteIndex << 3;
+  uint8_t mask = 0;
+  for (int b = 0; b < 8; b++) {
+    if (first + b >= from && first + b <= to) mask |= 1 << b;
+  }
+  return mask;
+}
+
+// Habilitar o deshabilitar las tarjetas [fromCard, toCard] de un rango.
+// Se recorre el mapa por bloques de RANGE_IO_BLOCK bytes y solo se reescriben
+// los bloques que cambian. Devuelve cuántas tarjetas cambiaron de estado.
+uint32_t setCardRangeBits(int index, uint32_t fromCard, uint32_t toCard, bool enable) {
+  CardRange& range = cardRanges[index];
+  uint32_t last = range.firstCard + range.count - 1;
+  if (fromCard < range.firstCard) fromCard = range.firstCard;
+  if (toCard > last) toCard = last;
+  if (fromCard > toCard) return 0;
+
+  char path[16];
+  cardRangePath(path, sizeof(path), range.file);
+  File file = SPIFFS.open(path, "r+");
+  if (!file) return 0;
+
+  uint32_t from = fromCard - range.firstCard;
+  uint32_t to = toCard - range.firstCard;
+  uint32_t changed = 0;
+  uint8_t block[RANGE_IO_BLOCK];
+  for (uint32_t start = from >> 3; start <= (to >> 3); start += RANGE_IO_BLOCK) {
+    uint32_t len = (to >> 3) - start + 1;
+    if (len > RANGE_IO_BLOCK) len = RANGE_IO_BLOCK;
+    file.seek(start, SeekSet);
+    if (file.read(block, len) != len) break;
+
+    uint32_t blockChanged = 0;
+    for (uint32_t i = 0; i < len; i++) {
+      uint8_t mask = cardRangeByteMask(start + i, from, to);
+      uint8_t value = enable ? (block[i] | mask) : (block[i] & ~mask);
+      blockChanged += __builtin_popcount(value ^ block[i]);
+      block[i] = value;
+    }
+    if (blockChanged > 0) {
+      file.seek(start, SeekSet);
+      file.write(block, len);
+      changed += blockChanged;
+    }
+    yield();
+  }
+  file.close();
+  invalidateCardRangeCache(range.file);
+
+  if (enable) range.enabled += changed;
+  else range.enabled -= changed;
+  return changed;
+}
+
+// Crear un rango con todas sus tarjetas habilitadas o deshabilitadas.
+// Devuelve la posición en cardRanges[] o -1 si no cabe o se solapa.
+int createCardRange(uint32_t firstCard, uint32_t count, uint8_t group, const char* label, bool enable) {
+  if (cardRangeCount >= MAX_CARD_RANGES || count == 0 || count > MAX_RANGE_CARDS) return -1;
+  if (firstCard + count - 1 < firstCard || cardRangeOverlaps(firstCard, count)) return -1;
+
+  // Primer número de archivo libre
+  uint8_t fileNumber = 0;
+  for (bool used = true; used; ) {
+    used = false;
+    for (int i = 0; i < cardRangeCount; i++) {
+      if (cardRanges[i].file == fileNumber) {
+        used = true;
+        fileNumber++;
+        break;
+      }
+    }
+  }
+
+  char path[16];
+  cardRangePath(path, sizeof(path), fileNumber);
+  File file = SPIFFS.open(path, "w");
+  if (!file) return -1;
+  invalidateCardRangeCache(fileNumber);
+
+  // Los bits sobrantes del último byte quedan siempre a cero
+  uint8_t block[RANGE_IO_BLOCK];
+  uint32_t bytes = (count + 7) >> 3;
+  memset(block, enable ? 0xFF : 0x00, sizeof(block));
+  for (uint32_t written = 0; written < bytes; ) {
+    uint32_t len = bytes - written;
+    if (len > RANGE_IO_BLOCK) len = RANGE_IO_BLOCK;
+    if (written + len == bytes && enable && (count & 7)) {
+      block[len - 1] = (1 << (count & 7)) - 1;
+    }
+    file.write(block, len);
+    written += len;
+    yield();
+  }
+  file.close();
+
+  CardRange& range = cardRanges[cardRangeCount++];
+  range.firstCard = firstCard;
+  range.count = count;
+  range.enabled = enable ? count : 0;
+  range.group = group;
+  range.file = fileNumber;
+  strlcpy(range.label, label, sizeof(range.label));
+  return cardRangeCount - 1;
+}
+
+// Eliminar un rango y su mapa de bits
+void deleteCardRange(int index) {
+  char path[16];
+  cardRangePath(path, sizeof(path), cardRanges[index].file);
+  SPIFFS.remove(path);
+  invalidateCardRangeCache(cardRanges[index].file);
+  for (int i = index; i < cardRangeCount - 1; i++) {
+    cardRanges[i] = cardRanges[i + 1];
+  }
+  cardRangeCount--;
+}
+
+// Identificador con el que se registran los accesos por rango: el número de
+// tarjeta en los 4 bytes bajos del ID de usuario, con CARD_RANGE_ID_MARK en
+// el primero. Esos IDs (desde 0xFF00000000, más de 10 cifras) quedan
+// reservados: no se admiten usuarios con ellos, así que un acceso por rango
+// nunca se confunde con uno de un empleado.
+void cardRangeRecordId(uint32_t cardId, uint8_t* id) {
+  id[0] = CARD_RANGE_ID_MARK;
+  for (int j = 4; j >= 1; j--) {
+    id[j] = cardId & 0xFF;
+    cardId >>= 8;
+  }
+}
+
+// ¿Es un ID reservado para los accesos por rango?
+bool isCardRangeRecordId(const uint8_t* id) {
+  return id[0] == CARD_RANGE_ID_MARK;
+}
+
+#endif // RANGOS_H
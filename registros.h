@@ -0,0 +1,199 @@
+/**
+ * registros.h
+ * Almacén circular de registros de acceso: alta, índice temporal disperso y
+ * motor de consultas por rango de tiempo y usuario
+ */
+
+#ifndef REGISTROS_H
+#define REGISTROS_H
+
+// records[] es un búfer circular: recordCount es el número de secuencia del
+// próximo registro y el registro con secuencia S vive en records[S % MAX_RECORDS].
+// Las secuencias nunca se reutilizan: borrar los registros solo adelanta
+// recordBase, para que el colector, los cursores de la API y los eventos no
+// confundan los registros nuevos con los ya vistos.
+//
+// Índice disperso: cada bloque de RECORD_BLOCK_SIZE secuencias consecutivas
+// tiene un resumen con su rango de tiempo y un filtro de Bloom de usuarios.
+// Hay un resumen más de los que caben en el búfer para que el bloque que se
+// está sobrescribiendo conserve el suyo hasta desaparecer por completo.
+#define RECORD_BLOCK_COUNT (MAX_RECORDS / RECORD_BLOCK_SIZE + 1)
+
+RecordBlockSummary recordBlocks[RECORD_BLOCK_COUNT];
+
+// Declaración de funciones externas (definidas en asistencia.h y descargas.h)
+extern void updateAttendance(const AccessRecord& record);
+extern void clampDownloadCursors();
+
+// ========= ACCESO AL BÚFER ===========
+
+// Número de secuencia del registro más antiguo todavía almacenado
+uint32_t firstRecordSeq() {
+  uint32_t oldest = ((uint32_t)recordCount > MAX_RECORDS) ? recordCount - MAX_RECORDS : 0;
+  return (recordBase > oldest) ? recordBase : oldest;
+}
+
+// Cantidad de registros realmente almacenados en el búfer
+int storedRecordCount() {
+  return recordCount - firstRecordSeq();
+}
+
+// Acceder a un registro por su número de secuencia
+// (válido para firstRecordSeq() <= seq < recordCount)
+AccessRecord& recordBySeq(uint32_t seq) {
+  return records[seq % MAX_RECORDS];
+}
+
+// Copiar count registros desde la secuencia first tal como van en la trama
+// (14 bytes cada uno): como mucho dos copias, por la vuelta del búfer
+void copyWireRecords(uint8_t* out, uint32_t first, int count) {
+  uint32_t pos = first % MAX_RECORDS;
+  int head = (pos + count > MAX_RECORDS) ? MAX_RECORDS - pos : count;
+  memcpy(out, &records[pos], head * sizeof(AccessRecord));
+  memcpy(out + head * sizeof(AccessRecord), &records[0], (count - head) * sizeof(AccessRecord));
+}
+
+// ========= HORA DE LOS REGISTROS ===========
+// CrossChex muestra los registros un día después de su hora real, así que
+// la hora se guarda ya corregida (un día menos) en el formato de la trama y
+// se deshace la corrección al leerla para la web, la API o la asistencia.
+// Los registros subidos con 0x41 ya vienen en el formato de la trama.
+#define RECORD_DAY_CORRECTION 86400UL
+
+// Hora local del registro (segundos desde 2000-01-01)
+uint32_t recordTime(const AccessRecord& record) {
+  uint32_t wire = ((uint32_t)record.time[0] << 24) | ((uint32_t)record.time[1] << 16) |
+                  ((uint32_t)record.time[2] << 8) | record.time[3];
+  return wire + RECORD_DAY_CORRECTION;
+}
+
+void setRecordTime(AccessRecord& record, uint32_t timestamp) {
+  uint32_t wire = timestamp - RECORD_DAY_CORRECTION;
+  record.time[0] = (wire >> 24) & 0xFF;
+  record.time[1] = (wire >> 16) & 0xFF;
+  record.time[2] = (wire >> 8) & 0xFF;
+  record.time[3] = wire & 0xFF;
+}
+
+// ========= ÍNDICE TEMPORAL ===========
+
+// Posiciones del filtro de Bloom (dos funciones hash sobre el ID de 5 bytes)
+void userBloomBits(const uint8_t* id, uint8_t& bit1, uint8_t& bit2) {
+  uint32_t h = 2166136261UL;  // FNV-1a
+  for (int i = 0; i < 5; i++) {
+    h = (h ^ id[i]) * 16777619UL;
+  }
+  bit1 = h & 63;
+  bit2 = (h >> 6) & 63;
+}
+
+// Añadir la secuencia seq (ya escrita en records[]) a su bloque
+void indexRecord(uint32_t seq) {
+  const AccessRecord& record = recordBySeq(seq);
+  uint32_t block = seq / RECORD_BLOCK_SIZE;
+  RecordBlockSummary& summary = recordBlocks[block % RECORD_BLOCK_COUNT];
+  if (summary.block != block) {
+    // Primer registro del bloque: el resumen anterior ya no cubre nada almacenado
+    summary.block = block;
+    summary.minTime = recordTime(record);
+    summary.maxTime = recordTime(record);
+    summary.userBloom[0] = 0;
+    summary.userBloom[1] = 0;
+  }
+  uint32_t timestamp = recordTime(record);
+  if (timestamp < summary.minTime) summary.minTime = timestamp;
+  if (timestamp > summary.maxTime) summary.maxTime = timestamp;
+  uint8_t bit1, bit2;
+  userBloomBits(record.id, bit1, bit2);
+  summary.userBloom[bit1 >> 5] |= 1UL << (bit1 & 31);
+  summary.userBloom[bit2 >> 5] |= 1UL << (bit2 & 31);
+}
+
+// Reconstruir el índice completo (tras cargar desde flash)
+void rebuildRecordIndex() {
+  for (int i = 0; i < RECORD_BLOCK_COUNT; i++) {
+    recordBlocks[i].block = UINT32_MAX;
+  }
+  for (uint32_t seq = firstRecordSeq(); seq < (uint32_t)recordCount; seq++) {
+    indexRecord(seq);
+  }
+}
+
+// ========= ALTA Y BORRADO ===========
+
+// Añadir un registro al búfer (sobrescribe el más antiguo si está lleno) y a
+// los resúmenes de asistencia. Es el único punto de alta: acceso local,
+// subida por protocolo, etc.
+// Devuelve la secuencia asignada.
+uint32_t appendRecord(const AccessRecord& record) {
+  uint32_t seq = recordCount;
+  records[seq % MAX_RECORDS] = record;
+  indexRecord(seq);
+  updateAttendance(record);
+  recordCount++;
+  newRecordCount++;
+  return seq;
+}
+
+// Borrar todos los registros. La secuencia sigue donde estaba; el cursor de
+// envío se ajusta a recordBase en la próxima pasada de pumpPush().
+void clearRecords() {
+  recordBase = recordCount;
+  newRecordCount = 0;
+  clampDownloadCursors();
+  rebuildRecordIndex();
+}
+
+// ========= CONSULTAS ===========
+
+// Preparar una consulta sin filtros desde la secuencia cursor hasta el último
+// registro actual. Los filtros se activan rellenando from/to/userId.
+void recordQueryInit(RecordQuery& q, uint32_t cursor) {
+  q.cursor = cursor;
+  q.end = recordCount;
+  q.from = 0;
+  q.to = UINT32_MAX;
+  q.filterUser = false;
+}
+
+// ¿Puede el bloque contener algún registro que cumpla la consulta?
+bool recordBlockMayMatch(const RecordQuery& q, uint32_t block) {
+  const RecordBlockSummary& summary = recordBlocks[block % RECORD_BLOCK_COUNT];
+  if (summary.block != block) return true;  // Sin resumen: no se puede descartar
+  if (summary.maxTime < q.from || summary.minTime > q.to) return false;
+  if (q.filterUser) {
+    uint8_t bit1, bit2;
+    userBloomBits(q.userId, bit1, bit2);
+    if (!(summary.userBloom[bit1 >> 5] & (1UL << (bit1 & 31)))) return false;
+    if (!(summary.userBloom[bit2 >> 5] & (1UL << (bit2 & 31)))) return false;
+  }
+  return true;
+}
+
+// Avanzar hasta el siguiente registro que cumple la consulta. Devuelve false
+// al terminar. Los bloques descartados por el índice se saltan enteros.
+// Si el búfer ha dado la vuelta durante la consulta, continúa por el más
+// antiguo que sigue almacenado.
+bool recordQueryNext(RecordQuery& q, uint32_t& seq) {
+  uint32_t first = firstRecordSeq();
+  if (q.cursor < first) q.cursor = first;
+
+  while (q.cursor < q.end) {
+    uint32_t block = q.cursor / RECORD_BLOCK_SIZE;
+    if (!recordBlockMayMatch(q, block)) {
+      q.cursor = (block + 1) * RECORD_BLOCK_SIZE;
+      continue;
+    }
+
+    const AccessRecord& record = recordBySeq(q.cursor);
+    uint32_t current = q.cursor++;
+    uint32_t timestamp = recordTime(record);
+    if (timestamp < q.from || timestamp > q.to) continue;
+    if (q.filterUser && memcmp(record.id, q.userId, 5) != 0) continue;
+    seq = current;
+    return true;
+  }
+  return false;
+}
+
+#endif // REGISTROS_H
@@ -0,0 +1,251 @@
+/**
+ * respuestas.h
+ * Escritura de respuestas HTTP: agrupación en chunks de un MSS y respuestas
+ * largas generadas por partes desde el loop para no retrasar el control de acceso
+ */
+
+#ifndef RESPUESTAS_H
+#define RESPUESTAS_H
+
+#define RESPONSE_MSS 1460             // TCP_MSS de lwIP en el ESP8266
+// Carga útil por chunk: un MSS menos la cabecera de tamaño ("5AC\r\n") y el
+// "\r\n" final, para que cada chunk ocupe como mucho un segmento TCP
+#define RESPONSE_CHUNK_PAYLOAD (RESPONSE_MSS - 8)
+#define RESPONSE_LINE_MAX 256         // Máximo de una llamada a responsePrintf
+
+#define MAX_HTTP_STREAMS 2            // Respuestas largas simultáneas
+#define HTTP_STREAM_PAYLOAD RESPONSE_CHUNK_PAYLOAD  // Búfer de datos por conexión (bytes)
+#define HTTP_STREAM_ITEM_MAX 200      // Máximo que puede escribir un paso del generador
+#define HTTP_STREAM_TIMEOUT 10000     // Abortar si el cliente no avanza en este tiempo (ms)
+
+// ========= ESCRITOR AGRUPADO ===========
+// Las páginas que se generan de una vez dentro del manejador escriben aquí en
+// lugar de llamar a webServer.sendContent por cada fragmento: el texto se
+// acumula hasta llenar un MSS y solo entonces se envía como un chunk. El
+// búfer es global porque solo se atiende una petición a la vez.
+
+typedef struct {
+  char data[RESPONSE_CHUNK_PAYLOAD];
+  size_t used;
+} ResponseWriter;
+
+ResponseWriter responseWriter;
+
+// Enviar lo acumulado como un único chunk
+void responseFlush() {
+  if (responseWriter.used > 0) {
+    webServer.sendContent(responseWriter.data, responseWriter.used);
+    responseWriter.used = 0;
+  }
+}
+
+// Iniciar una respuesta chunked
+void responseBegin(int code, const char* contentType) {
+  webServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  webServer.send(code, contentType, "");
+  responseWriter.used = 0;
+}
+
+// Terminar la respuesta: último chunk de datos y chunk vacío final
+void responseEnd() {
+  responseFlush();
+  webServer.sendContent("");
+}
+
+// Añadir texto en RAM de cualquier longitud
+void responseWrite(const char* text, size_t len) {
+  while (len > 0) {
+    size_t room = sizeof(responseWriter.data) - responseWriter.used;
+    size_t n = (len < room) ? len : room;
+    memcpy(&responseWriter.data[responseWriter.used], text, n);
+    responseWriter.used += n;
+    text += n;
+    len -= n;
+    if (responseWriter.used == sizeof(responseWriter.data)) responseFlush();
+  }
+}
+
+// Añadir texto PROGMEM de cualquier longitud
+void responseWrite_P(PGM_P text) {
+  size_t len = strlen_P(text);
+  while (len > 0) {
+    size_t room = sizeof(responseWriter.data) - responseWriter.used;
+    size_t n = (len < room) ? len : room;
+    memcpy_P(&responseWriter.data[responseWriter.used], text, n);
+    responseWriter.used += n;
+    text += n;
+    len -= n;
+    if (responseWriter.used == sizeof(responseWriter.data)) responseFlush();
+  }
+}
+
+// Añadir texto con formato (como máximo RESPONSE_LINE_MAX bytes por llamada)
+void responsePrintf(PGM_P format, ...) {
+  if (responseWriter.used + RESPONSE_LINE_MAX > sizeof(responseWriter.data)) {
+    responseFlush();
+  }
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf_P(&responseWriter.data[responseWriter.used], RESPONSE_LINE_MAX, format, args);
+  va_end(args);
+  if (n > 0) {
+    responseWriter.used += ((size_t)n < RESPONSE_LINE_MAX) ? n : RESPONSE_LINE_MAX - 1;
+  }
+}
+
+// ========= RESPUESTAS INCREMENTALES ===========
+
+struct HttpStream;
+
+// Generador: escribe el siguiente fragmento en out (como máximo room bytes,
+// room >= HTTP_STREAM_ITEM_MAX) y devuelve los bytes escritos. Debe poner
+// s.done = true cuando no quede nada por generar.
+typedef size_t (*HttpStreamStep)(HttpStream& s, char* out, size_t room);
+
+// Estado de una respuesta en curso. Los campos de recorrido son genéricos para
+// que cada generador guarde su posición sin memoria dinámica.
+struct HttpStream {
+  WiFiClient client;
+  bool active;
+  bool done;                  // El generador terminó
+  bool finished;              // Se encoló el chunk terminador
+  HttpStreamStep step;
+  uint8_t phase;              // Fase del generador (cabecera, filas, pie...)
+  uint8_t userId[5];          // Último usuario emitido (recorrido por ID)
+  bool userIdSet;             // false: aún no se ha emitido ninguno
+  RecordQuery query;          // Consulta sobre los registros (registros.h)
+  int sent;                   // Elementos emitidos
+  int limit;                  // Máximo de elementos
+  // Trama chunked: 8 bytes reservados para la cabecera de tamaño,
+  // la carga útil y el "\r\n" final
+  char data[8 + HTTP_STREAM_PAYLOAD + 2];
+  uint16_t chunkStart;        // Inicio del chunk pendiente en data
+  uint16_t chunkEnd;          // Fin del chunk pendiente en data
+  unsigned long lastProgress;
+};
+
+HttpStream httpStreams[MAX_HTTP_STREAMS];
+
+// Liberar la ranura de una respuesta
+void closeHttpStream(HttpStream& s) {
+  s.client.stop();
+  s.client = WiFiClient();
+  s.active = false;
+}
+
+// Tomar la conexión del servidor web y registrar un generador. Se escriben
+// las cabeceras directamente (sin webServer.send) para que el servidor no
+// cierre la respuesta chunked al volver del manejador.
+// Devuelve la ranura, o nullptr si no hay ranuras libres (ya respondió 503).
+HttpStream* beginHttpStream(const char* contentType, HttpStreamStep step, const char* extraHeaders = nullptr) {
+  HttpStream* s = nullptr;
+  for (int i = 0; i < MAX_HTTP_STREAMS; i++) {
+    if (!httpStreams[i].active) {
+      s = &httpStreams[i];
+      break;
+    }
+  }
+  if (s == nullptr) {
+    webServer.sendHeader("Retry-After", "1");
+    webServer.send(503, "text/plain", "Servidor ocupado, reintente");
+    return nullptr;
+  }
+
+  s->client = webServer.client();
+  s->client.setNoDelay(true);
+  s->client.print(F("HTTP/1.1 200 OK\r\nContent-Type: "));
+  s->client.print(contentType);
+  s->client.print(F("\r\nTransfer-Encoding: chunked\r\nConnection: close\r\n"));
+  if (extraHeaders != nullptr) {
+    s->client.print(extraHeaders);
+  }
+  s->client.print(F("\r\n"));
+
+  s->active = true;
+  s->done = false;
+  s->finished = false;
+  s->step = step;
+  s->phase = 0;
+  s->userIdSet = false;
+  recordQueryInit(s->query, firstRecordSeq());
+  s->sent = 0;
+  s->limit = INT_MAX;
+  s->chunkStart = 0;
+  s->chunkEnd = 0;
+  s->lastProgress = millis();
+  return s;
+}
+
+// Acotar el resultado de snprintf a lo realmente escrito
+size_t clampPrinted(int n, size_t room) {
+  if (n < 0) return 0;
+  return ((size_t)n < room) ? n : room - 1;
+}
+
+// Rellenar el búfer con pasos del generador y enmarcarlo como un chunk HTTP
+void fillHttpStream(HttpStream& s) {
+  char* payload = &s.data[8];
+  size_t used = 0;
+  while (!s.done && HTTP_STREAM_PAYLOAD - used >= HTTP_STREAM_ITEM_MAX) {
+    used += s.step(s, &payload[used], HTTP_STREAM_PAYLOAD - used);
+  }
+
+  if (used == 0) {
+    s.chunkStart = 0;
+    s.chunkEnd = 0;
+    return;
+  }
+
+  // Cabecera "<tamaño hex>\r\n" alineada justo antes de la carga útil
+  char header[8];
+  int headerLen = snprintf_P(header, sizeof(header), PSTR("%X\r\n"), (unsigned)used);
+  s.chunkStart = 8 - headerLen;
+  memcpy(&s.data[s.chunkStart], header, headerLen);
+  payload[used] = '\r';
+  payload[used + 1] = '\n';
+  s.chunkEnd = 8 + used + 2;
+}
+
+// Avanzar todas las respuestas en curso sin bloquear: solo se escribe lo que
+// el búfer TCP acepta ahora mismo y el resto queda para la próxima pasada.
+void pumpHttpStreams() {
+  for (int i = 0; i < MAX_HTTP_STREAMS; i++) {
+    HttpStream& s = httpStreams[i];
+    if (!s.active) continue;
+
+    if (!s.client.connected() || millis() - s.lastProgress > HTTP_STREAM_TIMEOUT) {
+      closeHttpStream(s);
+      continue;
+    }
+
+    if (s.chunkStart >= s.chunkEnd) {
+      if (s.finished) {
+        // Terminador ya enviado: respuesta completa
+        closeHttpStream(s);
+        continue;
+      }
+      if (s.done) {
+        // Chunk final de longitud cero
+        memcpy_P(s.data, PSTR("0\r\n\r\n"), 5);
+        s.chunkStart = 0;
+        s.chunkEnd = 5;
+        s.finished = true;
+      } else {
+        MemProfileScope memScope(MEM_OP_WEB);
+        fillHttpStream(s);
+        if (s.chunkStart >= s.chunkEnd) continue;
+      }
+    }
+
+    size_t room = s.client.availableForWrite();
+    if (room == 0) continue;
+    size_t remaining = s.chunkEnd - s.chunkStart;
+    size_t written = s.client.write((const uint8_t*)&s.data[s.chunkStart], remaining < room ? remaining : room);
+    if (written > 0) {
+      s.chunkStart += written;
+      s.lastProgress = millis();
+    }
+  }
+}
+
+#endif // RESPUESTAS_H
@@ -0,0 +1,155 @@
+/**
+ * sesion.h
+ * Sesión TCP con CrossChex: cola de transmisión con control de flujo para
+ * que las respuestas largas no se trunquen en enlaces lentos, y cierre de
+ * sesiones muertas o inactivas
+ */
+
+#ifndef SESION_H
+#define SESION_H
+
+#define TX_QUEUE_SIZE 2048            // Cola de transmisión de la sesión (bytes)
+#define TX_MAX_RESPONSE 512           // Respuesta más larga de un comando (0x6E: 401 bytes)
+#define SESSION_TX_STALL_TIMEOUT 30000 // Cerrar si la cola no avanza durante este tiempo (ms)
+#define SESSION_KEEPALIVE_INTERVAL 5  // Segundos entre sondeos keepalive
+#define SESSION_KEEPALIVE_COUNT 3     // Sondeos sin respuesta antes de dar la conexión por muerta
+
+// Las respuestas se copian a un anillo y se escriben solo en la medida en
+// que hay hueco en el búfer TCP; lo que no cabe sale en pasadas siguientes
+// del loop. Mientras no quepa una respuesta completa no se leen comandos
+// nuevos (los datos esperan en el búfer de recepción y TCP frena al cliente).
+uint8_t txQueue[TX_QUEUE_SIZE];
+uint16_t txHead = 0;                  // Próximo byte a enviar
+uint16_t txCount = 0;                 // Bytes en cola
+uint32_t txQueuedTotal = 0;           // Posición en el flujo tras el último byte encolado
+uint32_t txWrittenTotal = 0;          // Posición en el flujo tras el último byte escrito en el socket
+unsigned long txLastProgress = 0;     // Último envío que avanzó la cola
+
+// Estado de la sesión. Solo hay una: el client global de variables.h.
+bool sessionActive = false;
+unsigned long sessionOpenedAt = 0;
+unsigned long sessionLastActivity = 0; // Último comando recibido
+
+// ========= COLA DE TRANSMISIÓN ===========
+
+// Escribir en el socket lo que quepa ahora, sin bloquear
+void pumpSessionTx() {
+  while (txCount > 0 && client.connected()) {
+    size_t room = client.availableForWrite();
+    if (room == 0) return;
+    size_t chunk = (txHead + txCount > TX_QUEUE_SIZE) ? TX_QUEUE_SIZE - txHead : txCount;
+    if (chunk > room) chunk = room;
+    size_t written = client.write(&txQueue[txHead], chunk);
+    if (written == 0) return;
+    txLastProgress = millis();
+    txHead = (txHead + written) % TX_QUEUE_SIZE;
+    txCount -= written;
+    txWrittenTotal += written;
+  }
+}
+
+// Encolar una respuesta completa e intentar enviarla ya. Devuelve false si
+// no cabe (no debería ocurrir: sessionCanAccept() reserva TX_MAX_RESPONSE).
+bool sessionSend(const uint8_t* data, size_t len) {
+  if (len > TX_QUEUE_SIZE - txCount) {
+    metrics.txOverflows++;
+    return false;
+  }
+  if (txCount == 0) txLastProgress = millis();
+  for (size_t i = 0; i < len; i++) {
+    txQueue[(txHead + txCount + i) % TX_QUEUE_SIZE] = data[i];
+  }
+  txCount += len;
+  txQueuedTotal += len;
+  pumpSessionTx();
+  if (txCount > 0) metrics.txDeferred++;
+  return true;
+}
+
+// Quitar de la cola lo encolado desde la posición position del flujo. Solo
+// si aún no ha empezado a salir: una trama a medias no se puede retirar.
+bool sessionDropQueuedFrom(uint32_t position) {
+  if ((int32_t)(position - txWrittenTotal) < 0 || (int32_t)(txQueuedTotal - position) < 0) return false;
+  txCount = position - txWrittenTotal;
+  txQueuedTotal = position;
+  return true;
+}
+
+// ¿Se puede procesar otro comando? Solo si cabe la respuesta más larga.
+bool sessionCanAccept() {
+  return TX_QUEUE_SIZE - txCount >= TX_MAX_RESPONSE;
+}
+
+// ========= CICLO DE VIDA ===========
+
+// Cerrar la sesión y liberar el socket y la cola. Un lote de registros sin
+// confirmar se reenviará en la próxima sesión (descargas.h).
+void closeSession(uint8_t reason) {
+  if (!sessionActive) return;
+  uint32_t lifetime = (millis() - sessionOpenedAt) / 1000;
+  recordSessionClose(reason, lifetime);
+
+  client.stop();
+  client = WiFiClient();  // Soltar la referencia al contexto TCP y sus búferes
+  sessionActive = false;
+  txHead = 0;
+  txCount = 0;
+  txQueuedTotal = txWrittenTotal;
+  resetDownloadSession();
+  Serial.print("Sesion TCP cerrada tras ");
+  Serial.print(lifetime);
+  Serial.println(" s");
+}
+
+void openSession(WiFiClient& incoming) {
+  client = incoming;
+  client.setNoDelay(true);
+  if (basicConfig.keepAliveIdle > 0) {
+    client.keepAlive(basicConfig.keepAliveIdle, SESSION_KEEPALIVE_INTERVAL, SESSION_KEEPALIVE_COUNT);
+  }
+  sessionActive = true;
+  sessionOpenedAt = millis();
+  sessionLastActivity = millis();
+  metrics.sessionsOpened++;
+  Serial.println("Nuevo cliente TCP conectado");
+}
+
+// Llamar en cada iteración del loop. Una sesión se cierra cuando el otro
+// extremo la cierra o el keepalive la da por muerta, cuando pasa
+// sessionIdleTimeout sin comandos, cuando la cola de transmisión no avanza
+// o cuando el mismo equipo abre otra conexión (la anterior quedó medio
+// abierta). Otra conexión con una sesión viva se rechaza.
+void pumpSession() {
+  if (sessionActive && !client.connected()) {
+    closeSession(SESSION_CLOSE_PEER);
+  }
+
+  WiFiClient incoming = server.available();
+  if (incoming) {
+    if (sessionActive && incoming.remoteIP() == client.remoteIP()) {
+      closeSession(SESSION_CLOSE_REPLACED);
+    }
+    if (sessionActive) {
+      incoming.stop();
+      metrics.sessionsRejected++;
+    } else {
+      openSession(incoming);
+    }
+  }
+  if (!sessionActive) return;
+
+  if (client.available() > 0) {
+    sessionLastActivity = millis();
+  } else if (basicConfig.sessionIdleTimeout > 0 && txCount == 0 &&
+             millis() - sessionLastActivity > basicConfig.sessionIdleTimeout * 1000UL) {
+    closeSession(SESSION_CLOSE_IDLE);
+    return;
+  }
+
+  pumpSessionTx();
+  if (txCount > 0 && millis() - txLastProgress > SESSION_TX_STALL_TIMEOUT) {
+    closeSession(SESSION_CLOSE_STALLED);
+  }
+}
+
+#endif // SESION_H
@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""
+gen_assets.py
+Genera assets.h a partir de web_assets/: cada fichero se comprime con gzip
+y se guarda como array PROGMEM junto con su ETag (hash del contenido).
+
+Uso: python3 tools/gen_assets.py   (desde la raíz del proyecto)
+Volver a ejecutarlo tras modificar cualquier fichero de web_assets/.
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE_DIR = os.path.join(ROOT, "web_assets")
+OUTPUT = os.path.join(ROOT, "assets.h")
+
+# Fichero fuente -> (identificador C, ruta URL, tipo MIME)
+ASSETS = [
+    ("app.css", "appCss", "/app.css", "text/css"),
+    ("app.js", "appJs", "/app.js", "application/javascript"),
+]
+
+
+def c_array(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("  " + ", ".join("0x%02X" % b for b in data[i:i + 16]))
+    return ",\n".join(lines)
+
+
+def main():
+    out = [
+        "/**",
+        " * assets.h",
+        " * Recursos estáticos de la interfaz web comprimidos con gzip.",
+        " * GENERADO por tools/gen_assets.py a partir de web_assets/: no editar a mano.",
+        " */",
+        "",
+        "#ifndef ASSETS_H",
+        "#define ASSETS_H",
+        "",
+    ]
+    for source, name, url, mime in ASSETS:
+        with open(os.path.join(SOURCE_DIR, source), "rb") as f:
+            raw = f.read()
+        # mtime=0 para que la salida sea reproducible
+        packed = gzip.compress(raw, compresslevel=9, mtime=0)
+        etag = hashlib.sha1(raw).hexdigest()[:8]
+        out += [
+            "// %s: %d bytes, %d comprimido" % (url, len(raw), len(packed)),
+            "#define %s_ETAG \"%s\"" % (re.sub(r"(?<!^)(?=[A-Z])", "_", name).upper(), etag),
+            "static const uint8_t %sGz[] PROGMEM = {" % name,
+            c_array(packed),
+            "};",
+            "",
+        ]
+    out += ["#endif // ASSETS_H", ""]
+    with open(OUTPUT, "w", newline="\n") as f:
+        f.write("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
@@ -16,22 +16,24 @@ String getFormattedDateTime() {
   return String(buffer);
 }
 
-// Formatear timestamp Anviz a fecha/hora legible
-String formatTimestamp(uint32_t timestamp) {
+// Formatear timestamp Anviz en un búfer (sin asignar memoria dinámica)
+void formatTimestampTo(char* buffer, size_t len, uint32_t timestamp) {
   // El timestamp Anviz es segundos desde 2000-01-01
   // Ajustamos a Unix timestamp (segundos desde 1970-01-01)
   time_t unixTime = timestamp + 946684800;
   
-  // Convertir a año, mes, día, etc.
-  int yr = year(unixTime);
-  int mo = month(unixTime);
-  int dy = day(unixTime);
-  int hr = hour(unixTime);
-  int mn = minute(unixTime);
-  int sc = second(unixTime);
+  // Descomponer una sola vez en año, mes, día, etc.
+  tmElements_t tm;
+  breakTime(unixTime, tm);
   
+  snprintf_P(buffer, len, PSTR("%04d-%02d-%02d %02d:%02d:%02d"),
+             tmYearToCalendar(tm.Year), tm.Month, tm.Day, tm.Hour, tm.Minute, tm.Second);
+}
+
+// Formatear timestamp Anviz a fecha/hora legible
+String formatTimestamp(uint32_t timestamp) {
   char buffer[30];
-  sprintf(buffer, "%04d-%02d-%02d %02d:%02d:%02d", yr, mo, dy, hr, mn, sc);
+  formatTimestampTo(buffer, sizeof(buffer), timestamp);
   return String(buffer);
 }
 
@@ -46,13 +48,93 @@ void blinkError(int count) {
 }
 
 // ========= FUNCIONES DE UTILIDAD PARA MANEJAR USUARIOS Y REGISTROS ===========
-int findUserByCardId(uint32_t cardId) {
-  for (int i = 0; i < userCount; i++) {
-    if (users[i].cardId == cardId && users[i].isActive) {
-      return i;
+
+// Escribir el ID de usuario de 5 bytes en decimal sin usar String
+void formatUserId(char* buffer, size_t len, const uint8_t* id) {
+  uint64_t value = 0;
+  for (int j = 0; j < 5; j++) {
+    value = (value << 8) | id[j];
+  }
+  char digits[21];
+  int n = 0;
+  do {
+    digits[n++] = '0' + (value % 10);
+    value /= 10;
+  } while (value > 0);
+  size_t pos = 0;
+  while (n > 0 && pos + 1 < len) {
+    buffer[pos++] = digits[--n];
+  }
+  buffer[pos] = 0;
+}
+
+// Convertir un ID de usuario decimal a los 5 bytes del protocolo
+bool parseUserId(const char* text, uint8_t* id) {
+  uint64_t value = 0;
+  if (*text == 0) return false;
+  for (; *text; text++) {
+    if (*text < '0' || *text > '9') return false;
+    value = value * 10 + (*text - '0');
+    if (value > 0xFFFFFFFFFFULL) return false; // Máximo 40 bits
+  }
+  for (int j = 4; j >= 0; j--) {
+    id[j] = value & 0xFF;
+    value >>= 8;
+  }
+  return !isCardRangeRecordId(id); // IDs reservados para los rangos de tarjetas
+}
+
+// Copiar un nombre de usuario escapado para JSON (los nombres pueden no tener terminador)
+void jsonEscapeName(char* buffer, size_t len, const char* name) {
+  size_t pos = 0;
+  for (int i = 0; i < 10 && name[i] && pos + 7 < len; i++) {
+    char c = name[i];
+    if (c == '"' || c == '\\') {
+      buffer[pos++] = '\\';
+      buffer[pos++] = c;
+    } else if ((uint8_t)c < 0x20) {
+      pos += snprintf_P(&buffer[pos], len - pos, PSTR("\\u%04x"), (uint8_t)c);
+    } else {
+      buffer[pos++] = c;
     }
   }
-  return -1; // No encontrado
+  buffer[pos] = 0;
+}
+
+int findUserByCardId(uint32_t cardId) {
+  return indexFindUserByCardId(cardId); // -1 si no se encuentra
+}
+
+// ========= CONEXIONES SALIENTES ===========
+// WiFiClient::connect() bloquea el loop durante la resolución DNS y el
+// establecimiento TCP. El host se resuelve una sola vez (de nuevo si cambia
+// en la configuración o tras varios fallos seguidos) y la conexión a la IP
+// se acota con un tiempo corto, así que un destino caído detiene el loop
+// como mucho timeoutMs en cada reintento. Las tramas Wiegand que lleguen
+// entretanto esperan en las colas de los lectores.
+#define OUTBOUND_DNS_TIMEOUT 1000      // Resolución DNS, solo la primera vez (ms)
+#define OUTBOUND_RESOLVE_FAILURES 4    // Fallos seguidos antes de volver a resolver
+
+bool connectOutbound(WiFiClient& net, OutboundTarget& target, const char* host, uint16_t port, uint16_t timeoutMs) {
+  if (!target.resolved || strcmp(target.host, host) != 0) {
+    IPAddress address;
+    if (!WiFi.hostByName(host, address, OUTBOUND_DNS_TIMEOUT)) return false;
+    strncpy(target.host, host, sizeof(target.host) - 1);
+    target.host[sizeof(target.host) - 1] = 0;
+    target.address = address;
+    target.resolved = true;
+    target.failures = 0;
+  }
+
+  net.stop();
+  net.setTimeout(timeoutMs);
+  if (!net.connect(target.address, port)) {
+    if (++target.failures >= OUTBOUND_RESOLVE_FAILURES) target.resolved = false;
+    return false;
+  }
+  target.failures = 0;
+  net.setNoDelay(true);
+  return true;
 }
 
 #endif // UTILIDADES_H
\ No newline at end of file
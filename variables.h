@@ -6,13 +6,20 @@
 #ifndef VARIABLES_H
 #define VARIABLES_H
 
+// ========= CAPACIDADES ===========
+#define MAX_USERS 100                  // Capacidad de la tabla de usuarios
+#define MAX_RECORDS 500                // Capacidad del búfer circular de registros
+#define BULK_MAX_PAGES 40              // Máximo de basicConfig.bulkPages (tramas por petición masiva)
+#define BULK_REQUEST_FLAG 0x80         // Bit del parámetro de 0x40/0x42 que pide la respuesta masiva (extensión propia)
+
 // ========= VARIABLES GLOBALES ===========
 WiFiServer server(SERVER_PORT);        // Servidor TCP
 WiFiClient client;                     // Cliente conectado actual
-User users[100];                       // Máximo 100 usuarios
+User users[MAX_USERS];                 // Máximo 100 usuarios
 int userCount = 0;                     // Contador de usuarios
-AccessRecord records[500];             // Buffer para registros de acceso
-int recordCount = 0;                   // Contador total de registros
+AccessRecord records[MAX_RECORDS];     // Buffer circular para registros de acceso
+int recordCount = 0;                   // Contador total de registros (secuencia del próximo registro)
+uint32_t recordBase = 0;               // Secuencia del primer registro tras el último borrado
 int newRecordCount = 0;                // Contador de nuevos registros
 BasicConfig basicConfig;               // Configuración básica
 char serialNumber[17] = {0};           // SN del dispositivo (16 bytes máximo)
@@ -24,7 +31,13 @@ NTPClient timeClient(ntpUDP, "pool.ntp.org");
 
 // Estado para seguimiento de descargas
 int lastDownloadUserIndex = 0;         // Último índice de usuario descargado
-int lastDownloadRecordIndex = 0;       // Último índice de registro descargado
+
+// Envío de registros a un colector (envio.h)
+PushConfig pushConfig;                 // Destino y modo
+uint32_t pushCursor = 0;               // Secuencia del primer registro sin confirmar
+
+// Publicación de eventos por MQTT (mqtt.h)
+MqttConfig mqttConfig;
 
 // Servidor web para configuración
 ESP8266WebServer webServer(80);        // Servidor web en puerto 80
@@ -6,41 +6,22 @@
 
 
 // Prototipos de funciones de utilidad
-String uint64ToString(uint64_t input);
 int findUserById(uint8_t* id);
 
-// Variable para manejo de subida de archivos
-File uploadFile;
-
 // Declaracion de funciones externas necesarias de utilidades.h
 extern String getFormattedDateTime();
 extern String formatTimestamp(uint32_t timestamp);
 extern void saveWebAuth();
 extern void saveRecords();
+extern void saveSchedules();
+extern void savePushConfig();
+extern void saveMqttConfig();
 
 // ========= FUNCIONES DE UTILIDAD ===========
 
-// Funcion para convertir uint64_t a String
-String uint64ToString(uint64_t input) {
-  String result = "";
-  if (input == 0) {
-    return "0";
-  }
-  while (input > 0) {
-    result = String(input % 10) + result;
-    input /= 10;
-  }
-  return result;
-}
-
 // Funcion para buscar un usuario por su ID de 5 bytes
 int findUserById(uint8_t* id) {
-  for (int i = 0; i < userCount; i++) {
-    if (memcmp(users[i].id, id, 5) == 0) {
-      return i;
-    }
-  }
-  return -1;
+  return indexFindUserById(id);
 }
 
 // Funcion para verificar la autenticacion
@@ -54,227 +35,180 @@ bool isAuthenticated() {
   return false;
 }
 
-// ========= FUNCIONES DEL SERVIDOR WEB ===========
-
-// Pagina principal
-void handleRoot() {
-  if (!isAuthenticated()) return;
-
-  webServer.sendHeader("Content-Type", "text/html; charset=UTF-8");
-  webServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
-
-  // Send header
-  webServer.sendContent_P(PSTR("<!DOCTYPE html><html><head><title>Emulador Anviz</title>"));
-  webServer.sendContent_P(PSTR("<meta charset='UTF-8'><meta name='viewport' content='width=device-width, initial-scale=1'>"));
-  webServer.sendContent_P(PSTR("<style>body{font-family:Arial,sans-serif;margin:0;padding:20px;color:#333}h1{color:#0066cc}.menu{background-color:#f0f0f0;padding:10px;margin-bottom:20px}.menu a{margin-right:10px;color:#0066cc;text-decoration:none;padding:5px}.menu a:hover{background-color:#e0e0e0}.status{background-color:#e0f7fa;padding:15px;border-radius:5px}table{border-collapse:collapse;width:100%}th,td{border:1px solid #ddd;padding:8px;text-align:left}th{background-color:#f2f2f2}</style>"));
-  webServer.sendContent_P(PSTR("</head><body><h1>Emulador de Dispositivo Anviz</h1><div class='menu'><a href='/'>Inicio</a><a href='/users'>Usuarios</a><a href='/records'>Registros</a><a href='/settings'>Configuracion</a><a href='/auth'>Seguridad</a></div>"));
-
-  // Send status
-  char buffer[256];
-  webServer.sendContent_P(PSTR("<div class='status'><h2>Estado del Sistema</h2>"));
-  snprintf_P(buffer, sizeof(buffer), PSTR("<p>Direccion IP: %s</p>"), WiFi.localIP().toString().c_str());
-  webServer.sendContent(buffer);
-  snprintf_P(buffer, sizeof(buffer), PSTR("<p>Fuerza de senal WiFi: %d dBm</p>"), WiFi.RSSI());
-  webServer.sendContent(buffer);
-  snprintf_P(buffer, sizeof(buffer), PSTR("<p>SSID: %s</p>"), WiFi.SSID().c_str());
-  webServer.sendContent(buffer);
-  snprintf_P(buffer, sizeof(buffer), PSTR("<p>RAM Libre: %.2f KB</p>"), (float)ESP.getFreeHeap() / 1024.0);
-  webServer.sendContent(buffer);
-  FSInfo fsInfo;
-  SPIFFS.info(fsInfo);
-  snprintf_P(buffer, sizeof(buffer), PSTR("<p>Flash (SPIFFS) Libre: %.2f / %.2f MB</p>"), (float)(fsInfo.totalBytes - fsInfo.usedBytes) / (1024.0 * 1024.0), (float)fsInfo.totalBytes / (1024.0 * 1024.0));
-  webServer.sendContent(buffer);
-  snprintf_P(buffer, sizeof(buffer), PSTR("<p>Usuarios registrados: %d</p>"), userCount);
-  webServer.sendContent(buffer);
-  snprintf_P(buffer, sizeof(buffer), PSTR("<p>Registros de acceso: %d (nuevos: %d)</p>"), recordCount, newRecordCount);
-  webServer.sendContent(buffer);
-  snprintf_P(buffer, sizeof(buffer), PSTR("<p>Fecha y hora: %s</p>"), getFormattedDateTime().c_str());
-  webServer.sendContent(buffer);
-  webServer.sendContent_P(PSTR("</div>"));
-
-  // Send operations
-  webServer.sendContent_P(PSTR("<div><h2>Operaciones</h2><p><a href='/changewifi' onclick='return confirm(\"Esta seguro de querer cambiar la red WiFi? Se borrara la configuracion actual y el dispositivo se reiniciara en modo de configuracion.\");'>Cambiar Red WiFi</a></p>"));
-  webServer.sendContent_P(PSTR("<p><a href='/clearlogs' onclick='return confirm(\"Esta seguro de borrar todos los registros?\");'>Borrar registros</a></p>"));
-  webServer.sendContent_P(PSTR("<p><a href='/reset' onclick='return confirm(\"Esta seguro de reiniciar el dispositivo?\");'>Reiniciar dispositivo</a></p></div>"));
-
-  // Send footer
-  webServer.sendContent_P(PSTR("</body></html>"));
-  webServer.sendContent(""); // Terminate the connection
+// ========= PERFIL DE MEMORIA DE LAS PETICIONES ===========
+// El servidor llama al gancho al leer la línea de una petición; el perfil
+// "Pagina web" se abre ahí y se cierra al volver de handleClient(), así que
+// las pasadas del loop sin peticiones no toman muestras ni repintan la pila.
+// El gancho también acorta la espera de lectura del cliente: las cabeceras y
+// el cuerpo se leen de forma síncrona y un cliente lento podría retener el
+// loop (y las tarjetas) el tiempo de espera por defecto en cada lectura.
+#define WEB_REQUEST_READ_TIMEOUT 300  // ms máximos esperando cada lectura de la petición
+
+bool webRequestProfiled = false;
+MemOperation webRequestPreviousOp = MEM_OP_LOOP;
+
+ESP8266WebServer::ClientFuture webRequestHook(const String& method, const String& url, WiFiClient* client,
+                                              ESP8266WebServer::ContentTypeFunction contentType) {
+  client->setTimeout(WEB_REQUEST_READ_TIMEOUT);
+  if (!webRequestProfiled) {
+    webRequestProfiled = true;
+    webRequestPreviousOp = memProfileBegin(MEM_OP_WEB);
+  }
+  return ESP8266WebServer::CLIENT_REQUEST_CAN_CONTINUE;
 }
 
-// Pagina de usuarios
-void handleUsers() {
-  if (!isAuthenticated()) return;
-
-  webServer.sendHeader("Content-Type", "text/html; charset=UTF-8");
-  webServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
-
-  // Send header
-  webServer.sendContent_P(PSTR("<!DOCTYPE html><html><head><title>Usuarios - Emulador Anviz</title>"));
-  webServer.sendContent_P(PSTR("<meta charset='UTF-8'><meta name='viewport' content='width=device-width, initial-scale=1'>"));
-  webServer.sendContent_P(PSTR("<style>body{font-family:Arial,sans-serif;margin:0;padding:20px;color:#333}h1{color:#0066cc}.menu{background-color:#f0f0f0;padding:10px;margin-bottom:20px}.menu a{margin-right:10px;color:#0066cc;text-decoration:none;padding:5px}.menu a:hover{background-color:#e0e0e0}table{border-collapse:collapse;width:100%}th,td{border:1px solid #ddd;padding:8px;text-align:left}th{background-color:#f2f2f2}</style>"));
-  webServer.sendContent_P(PSTR("</head><body><h1>Usuarios Registrados</h1><div class='menu'><a href='/'>Inicio</a><a href='/users'>Usuarios</a><a href='/records'>Registros</a><a href='/settings'>Configuracion</a><a href='/auth'>Seguridad</a></div>"));
-
-  // Send table header
-  webServer.sendContent_P(PSTR("<table><tr><th>ID</th><th>Nombre</th><th>ID de Tarjeta</th><th>Departamento</th><th>Estado</th></tr>"));
+void endWebRequestProfile() {
+  if (!webRequestProfiled) return;
+  webRequestProfiled = false;
+  memProfileEnd(webRequestPreviousOp);
+}
 
-  // Send table rows
-  char buffer[256];
-  for (int i = 0; i < userCount; i++) {
-    webServer.sendContent_P(PSTR("<tr>"));
+// ========= PLANTILLA COMÚN DE PÁGINAS ===========
+// El estilo y el script se sirven aparte, comprimidos y cacheables (assets.h).
+// Cada página solo envía título, menú y su contenido propio; los datos los
+// pide el navegador a la API JSON.
+static const char pageHeadAssets[] PROGMEM =
+  "<meta charset='UTF-8'><meta name='viewport' content='width=device-width, initial-scale=1'>"
+  "<link rel='stylesheet' href='/app.css?v=" APP_CSS_ETAG "'>"
+  "<script src='/app.js?v=" APP_JS_ETAG "' defer></script></head>";
+static const char pageMenu[] PROGMEM =
+  "<div class='menu'><a href='/'>Inicio</a><a href='/users'>Usuarios</a><a href='/records'>Registros</a><a href='/schedule'>Horarios</a><a href='/settings'>Configuracion</a><a href='/auth'>Seguridad</a></div>";
+
+// Iniciar una página con la cabecera común. page selecciona el script de la
+// página en app.js. El contenido se agrupa en responseWriter (respuestas.h).
+void sendPageHead(const char* title, const char* page, const char* heading) {
+  responseBegin(200, "text/html; charset=UTF-8");
+  responsePrintf(PSTR("<!DOCTYPE html><html><head><title>%s</title>"), title);
+  responseWrite_P(pageHeadAssets);
+  responsePrintf(PSTR("<body data-page='%s'><h1>%s</h1>"), page, heading);
+  responseWrite_P(pageMenu);
+}
 
-    uint64_t userId_dec = 0;
-    for (int j = 0; j < 5; j++) {
-      userId_dec = (userId_dec << 8) | users[i].id[j];
-    }
-    snprintf_P(buffer, sizeof(buffer), PSTR("<td>%s</td>"), uint64ToString(userId_dec).c_str());
-    webServer.sendContent(buffer);
+void sendPageFoot() {
+  responseWrite_P(PSTR("</body></html>"));
+  responseEnd();
+}
 
-    snprintf_P(buffer, sizeof(buffer), PSTR("<td>%.10s</td>"), users[i].name);
-    webServer.sendContent(buffer);
+// Servir un recurso estático comprimido. El navegador lo pide con ?v=<hash>,
+// así que puede guardarlo un año; si revalida, basta con un 304 sin cuerpo.
+void sendGzipAsset(const uint8_t* data, size_t len, const char* contentType, const char* etag) {
+  webServer.sendHeader("ETag", etag);
+  if (webServer.hasHeader("If-None-Match") && webServer.header("If-None-Match") == etag) {
+    webServer.send(304, contentType, "");
+    return;
+  }
+  webServer.sendHeader("Cache-Control", "public, max-age=31536000, immutable");
+  webServer.sendHeader("Content-Encoding", "gzip");
+  webServer.send_P(200, contentType, (PGM_P)data, len);
+}
 
-    snprintf_P(buffer, sizeof(buffer), PSTR("<td>%u</td>"), users[i].cardId);
-    webServer.sendContent(buffer);
+void handleAppCss() {
+  sendGzipAsset(appCssGz, sizeof(appCssGz), "text/css", "\"" APP_CSS_ETAG "\"");
+}
 
-    snprintf_P(buffer, sizeof(buffer), PSTR("<td>%d</td>"), users[i].department);
-    webServer.sendContent(buffer);
+void handleAppJs() {
+  sendGzipAsset(appJsGz, sizeof(appJsGz), "application/javascript", "\"" APP_JS_ETAG "\"");
+}
 
-    snprintf_P(buffer, sizeof(buffer), PSTR("<td>%s</td>"), users[i].isActive ? "Activo" : "Inactivo");
-    webServer.sendContent(buffer);
+// ========= FUNCIONES DEL SERVIDOR WEB ===========
 
-    webServer.sendContent_P(PSTR("</tr>"));
-  }
+// Pagina principal (estado y memoria desde /api/status)
+void handleRoot() {
+  if (!isAuthenticated()) return;
 
-  webServer.sendContent_P(PSTR("</table>"));
+  sendPageHead("Emulador Anviz", "status", "Emulador de Dispositivo Anviz");
+  responseWrite_P(PSTR("<div class='status'><h2>Estado del Sistema</h2><div id='status'>Cargando...</div></div>"
+                               "<div><h2>Perfil de Memoria</h2><table id='mem'><tr><th>Operacion</th><th>Heap libre min.</th><th>Bloque max. min.</th><th>Fragmentacion max.</th><th>Pila libre min.</th><th>Muestras</th></tr></table></div>"
+                               "<div><h2>Operaciones</h2><p><a href='/changewifi' data-confirm='Esta seguro de querer cambiar la red WiFi? Se borrara la configuracion actual y el dispositivo se reiniciara en modo de configuracion.'>Cambiar Red WiFi</a></p>"
+                               "<p><a href='/clearlogs' data-confirm='Esta seguro de borrar todos los registros?'>Borrar registros</a></p>"
+                               "<p><a href='/reset' data-confirm='Esta seguro de reiniciar el dispositivo?'>Reiniciar dispositivo</a></p></div>"));
+  sendPageFoot();
+}
 
-  if (userCount == 0) {
-    webServer.sendContent_P(PSTR("<p>No hay usuarios registrados. Utilice el software Anviz CrossChex para anadir usuarios.</p>"));
-  }
+// Pagina de usuarios (filas desde /api/users, por páginas)
+void handleUsers() {
+  if (!isAuthenticated()) return;
 
-  // Send footer
-  webServer.sendContent_P(PSTR("</body></html>"));
-  webServer.sendContent(""); // Terminate the connection
+  sendPageHead("Usuarios - Emulador Anviz", "users", "Usuarios Registrados");
+  responseWrite_P(PSTR("<table id='users'><tr><th>ID</th><th>Nombre</th><th>ID de Tarjeta</th><th>Departamento</th><th>Estado</th></tr></table>"
+                               "<p id='msg'></p><button id='more' hidden>Mostrar mas</button>"));
+  sendPageFoot();
 }
 
-// Pagina de registros de acceso
+// Pagina de registros de acceso (últimos 50 desde /api/records y nuevos
+// accesos en vivo desde /events)
 void handleRecords() {
   if (!isAuthenticated()) return;
 
-  webServer.sendHeader("Content-Type", "text/html; charset=UTF-8");
-  webServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
-
-  // Send header
-  webServer.sendContent_P(PSTR("<!DOCTYPE html><html><head><title>Registros - Emulador Anviz</title>"));
-  webServer.sendContent_P(PSTR("<meta charset='UTF-8'><meta name='viewport' content='width=device-width, initial-scale=1'>"));
-  webServer.sendContent_P(PSTR("<style>body{font-family:Arial,sans-serif;margin:0;padding:20px;color:#333}h1{color:#0066cc}.menu{background-color:#f0f0f0;padding:10px;margin-bottom:20px}.menu a{margin-right:10px;color:#0066cc;text-decoration:none;padding:5px}.menu a:hover{background-color:#e0e0e0}table{border-collapse:collapse;width:100%}th,td{border:1px solid #ddd;padding:8px;text-align:left}th{background-color:#f2f2f2}</style>"));
-  webServer.sendContent_P(PSTR("</head><body><h1>Registros de Acceso</h1><div class='menu'><a href='/'>Inicio</a><a href='/users'>Usuarios</a><a href='/records'>Registros</a><a href='/settings'>Configuracion</a><a href='/auth'>Seguridad</a></div>"));
-
-  // Send table header
-  webServer.sendContent_P(PSTR("<table><tr><th>ID Usuario</th><th>Nombre</th><th>Fecha/Hora</th><th>Tipo</th><th>Metodo</th></tr>"));
-
-  // Send table rows
-  char buffer[256];
-  int startIdx = (recordCount > 50) ? (recordCount - 50) : 0;
-  int count = (recordCount > 50) ? 50 : recordCount;
-
-  for (int i = 0; i < count; i++) {
-    int idx = startIdx + i;
-    webServer.sendContent_P(PSTR("<tr>"));
-
-    uint64_t userId_dec = 0;
-    for (int j = 0; j < 5; j++) {
-      userId_dec = (userId_dec << 8) | records[idx].id[j];
-    }
-    snprintf_P(buffer, sizeof(buffer), PSTR("<td>%s</td>"), uint64ToString(userId_dec).c_str());
-    webServer.sendContent(buffer);
-
-    int userIndex = findUserById(records[idx].id);
-    const char* userName = (userIndex != -1) ? users[userIndex].name : "Desconocido";
-    snprintf_P(buffer, sizeof(buffer), PSTR("<td>%.10s</td>"), userName);
-    webServer.sendContent(buffer);
-
-    snprintf_P(buffer, sizeof(buffer), PSTR("<td>%s</td>"), formatTimestamp(records[idx].timestamp).c_str());
-    webServer.sendContent(buffer);
-
-    const char* recordType = (records[idx].recordType & 0x80) ? "Entrada" : "Salida";
-    snprintf_P(buffer, sizeof(buffer), PSTR("<td>%s</td>"), recordType);
-    webServer.sendContent(buffer);
-
-    const char* method;
-    switch (records[idx].backup) {
-      case 0x01: method = "Contrasena"; break;
-      case 0x02: method = "Huella digital"; break;
-      case 0x08: method = "Tarjeta"; break;
-      default: method = "Otro"; break;
-    }
-    snprintf_P(buffer, sizeof(buffer), PSTR("<td>%s</td>"), method);
-    webServer.sendContent(buffer);
-
-    webServer.sendContent_P(PSTR("</tr>"));
-  }
-
-  webServer.sendContent_P(PSTR("</table>"));
-
-  if (recordCount == 0) {
-    webServer.sendContent_P(PSTR("<p>No hay registros de acceso. Los registros se generaran cuando los usuarios utilicen sus tarjetas.</p>"));
-  } else if (recordCount > 50) {
-    snprintf_P(buffer, sizeof(buffer), PSTR("<p>Mostrando los ultimos 50 registros de un total de %d.</p>"), recordCount);
-    webServer.sendContent(buffer);
-  }
-
-  webServer.sendContent_P(PSTR("<p><a href='/clearlogs' onclick='return confirm(\"Esta seguro de borrar todos los registros?\");'>Borrar todos los registros</a></p>"));
-
-  // Send footer
-  webServer.sendContent_P(PSTR("</body></html>"));
-  webServer.sendContent(""); // Terminate the connection
+  sendPageHead("Registros - Emulador Anviz", "records", "Registros de Acceso");
+  responseWrite_P(PSTR("<table id='records'><tr><th>ID Usuario</th><th>Nombre</th><th>Fecha/Hora</th><th>Tipo</th><th>Metodo</th></tr></table>"
+                               "<p id='msg'></p><p><a href='/clearlogs' data-confirm='Esta seguro de borrar todos los registros?'>Borrar todos los registros</a></p>"));
+  sendPageFoot();
 }
 
 // Pagina de configuracion
 void handleSettings() {
   if (!isAuthenticated()) return;
 
-  webServer.sendHeader("Content-Type", "text/html; charset=UTF-8");
-  webServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
-
-  // Send header
-  webServer.sendContent_P(PSTR("<!DOCTYPE html><html><head><title>Configuracion - Emulador Anviz</title>"));
-  webServer.sendContent_P(PSTR("<meta charset='UTF-8'><meta name='viewport' content='width=device-width, initial-scale=1'>"));
-  webServer.sendContent_P(PSTR("<style>body{font-family:Arial,sans-serif;margin:0;padding:20px;color:#333}h1{color:#0066cc}.menu{background-color:#f0f0f0;padding:10px;margin-bottom:20px}.menu a{margin-right:10px;color:#0066cc;text-decoration:none;padding:5px}.menu a:hover{background-color:#e0e0e0}.config{background-color:#f9f9f9;padding:15px;border-radius:5px}table{border-collapse:collapse;width:100%}th,td{border:1px solid #ddd;padding:8px;text-align:left}th{background-color:#f2f2f2;width:40%}</style>"));
-  webServer.sendContent_P(PSTR("</head><body><h1>Configuracion del Emulador</h1><div class='menu'><a href='/'>Inicio</a><a href='/users'>Usuarios</a><a href='/records'>Registros</a><a href='/settings'>Configuracion</a><a href='/auth'>Seguridad</a></div>"));
+  sendPageHead("Configuracion - Emulador Anviz", "settings", "Configuracion del Emulador");
 
   // Send form
-  webServer.sendContent_P(PSTR("<div class='config'><form action='/savesettings' method='post'><table>"));
-  webServer.sendContent_P(PSTR("<tr><th>Parametro</th><th>Valor</th></tr>"));
-
-  char buffer[256];
-  snprintf_P(buffer, sizeof(buffer), PSTR("<tr><td>ID del dispositivo</td><td><input type='text' name='deviceId' value='%u'></td></tr>"), deviceId);
-  webServer.sendContent(buffer);
-  snprintf_P(buffer, sizeof(buffer), PSTR("<tr><td>Version de firmware</td><td>%s</td></tr>"), basicConfig.firmwareVersion);
-  webServer.sendContent(buffer);
-
-  webServer.sendContent_P(PSTR("<tr><td colspan='2' style='background-color:#e0f7fa;'><b>Configuracion de Pines GPIO</b></td></tr>"));
-  snprintf_P(buffer, sizeof(buffer), PSTR("<tr><td>Pin Wiegand D0</td><td><input type='text' name='pin_d0' value='%d'></td></tr>"), basicConfig.pin_d0);
-  webServer.sendContent(buffer);
-  snprintf_P(buffer, sizeof(buffer), PSTR("<tr><td>Pin Wiegand D1</td><td><input type='text' name='pin_d1' value='%d'></td></tr>"), basicConfig.pin_d1);
-  webServer.sendContent(buffer);
-  snprintf_P(buffer, sizeof(buffer), PSTR("<tr><td>Pin Rele</td><td><input type='text' name='pin_relay' value='%d'></td></tr>"), basicConfig.pin_relay);
-  webServer.sendContent(buffer);
-  snprintf_P(buffer, sizeof(buffer), PSTR("<tr><td>Pin LED de Estado</td><td><input type='text' name='pin_led' value='%d'></td></tr>"), basicConfig.pin_led);
-  webServer.sendContent(buffer);
-  snprintf_P(buffer, sizeof(buffer), PSTR("<tr><td>Tiempo de Activacion Rele (ms)</td><td><input type='number' name='relayOnDuration' min='500' max='10000' value='%d'></td></tr>"), basicConfig.relayOnDuration);
-  webServer.sendContent(buffer);
-
-  webServer.sendContent_P(PSTR("<tr><td colspan='2' style='background-color:#e0f7fa;'><b>Reinicio Automático</b></td></tr>"));
-  snprintf_P(buffer, sizeof(buffer), PSTR("<tr><td>Habilitar</td><td><input type='checkbox' name='rebootEnabled' %s></td></tr>"), basicConfig.rebootEnabled ? "checked" : "");
-  webServer.sendContent(buffer);
-  snprintf_P(buffer, sizeof(buffer), PSTR("<tr><td>Hora de Reinicio (HH:MM)</td><td><input type='number' name='rebootHour' min='0' max='23' value='%d'>:<input type='number' name='rebootMinute' min='0' max='59' value='%d'></td></tr>"), basicConfig.rebootHour, basicConfig.rebootMinute);
-  webServer.sendContent(buffer);
-
-  webServer.sendContent_P(PSTR("<tr><td colspan='2' style='background-color:#e0f7fa;'><b>Otros Parametros</b></td></tr>"));
-  snprintf_P(buffer, sizeof(buffer), PSTR("<tr><td>Numero de serie</td><td>%s</td></tr>"), serialNumber);
-  webServer.sendContent(buffer);
-  snprintf_P(buffer, sizeof(buffer), PSTR("<tr><td>Volumen</td><td>%d</td></tr>"), basicConfig.volume);
-  webServer.sendContent(buffer);
+  responseWrite_P(PSTR("<div class='config'><form action='/savesettings' method='post'><table>"));
+  responseWrite_P(PSTR("<tr><th>Parametro</th><th>Valor</th></tr>"));
+
+  responsePrintf(PSTR("<tr><td>ID del dispositivo</td><td><input type='text' name='deviceId' value='%u'></td></tr>"), deviceId);
+  responsePrintf(PSTR("<tr><td>Version de firmware</td><td>%s</td></tr>"), basicConfig.firmwareVersion);
+
+  responseWrite_P(PSTR("<tr class='section'><td colspan='2'>Configuracion de Pines GPIO</td></tr>"));
+  // Un lector por fila; los pines vacíos dejan la fila sin usar
+  for (int i = 0; i < MAX_READERS; i++) {
+    const ReaderConfig& reader = basicConfig.readers[i];
+    bool used = i < basicConfig.readerCount;
+    char d0Text[4] = "";
+    char d1Text[4] = "";
+    if (used) {
+      snprintf_P(d0Text, sizeof(d0Text), PSTR("%u"), reader.pin_d0);
+      snprintf_P(d1Text, sizeof(d1Text), PSTR("%u"), reader.pin_d1);
+    }
+    responsePrintf(PSTR("<tr><td>Lector %d: pines D0 / D1</td><td><input type='text' name='r%d_d0' value='%s' size='3'> / <input type='text' name='r%d_d1' value='%s' size='3'> "),
+                   i + 1, i, d0Text, i, d1Text);
+    responsePrintf(PSTR("<select name='r%d_dir'><option value='0'%s>Entrada</option><option value='1'%s>Salida</option></select></td></tr>"),
+                   i, (used && reader.direction == 1) ? "" : " selected", (used && reader.direction == 1) ? " selected" : "");
+  }
+  responsePrintf(PSTR("<tr><td>Pin Rele</td><td><input type='text' name='pin_relay' value='%d'></td></tr>"), basicConfig.pin_relay);
+  responsePrintf(PSTR("<tr><td>Pin LED de Estado</td><td><input type='text' name='pin_led' value='%d'></td></tr>"), basicConfig.pin_led);
+  responsePrintf(PSTR("<tr><td>Tiempo de Activacion Rele (ms)</td><td><input type='number' name='relayOnDuration' min='500' max='10000' value='%d'></td></tr>"), basicConfig.relayOnDuration);
+
+  responseWrite_P(PSTR("<tr class='section'><td colspan='2'>Reinicio Automático</td></tr>"));
+  responsePrintf(PSTR("<tr><td>Habilitar</td><td><input type='checkbox' name='rebootEnabled' %s></td></tr>"), basicConfig.rebootEnabled ? "checked" : "");
+  responsePrintf(PSTR("<tr><td>Hora de Reinicio (HH:MM)</td><td><input type='number' name='rebootHour' min='0' max='23' value='%d'>:<input type='number' name='rebootMinute' min='0' max='59' value='%d'></td></tr>"), basicConfig.rebootHour, basicConfig.rebootMinute);
+
+  responseWrite_P(PSTR("<tr class='section'><td colspan='2'>Lecturas Repetidas</td></tr>"));
+  responsePrintf(PSTR("<tr><td>Descartar repeticiones de la misma tarjeta durante (ms, 0 = no)</td><td><input type='number' name='duplicateWindow' min='0' max='60000' value='%u'></td></tr>"), basicConfig.duplicateWindow);
+  responsePrintf(PSTR("<tr><td>Anti-passback: segundos antes de repetir sentido (0 = desactivado)</td><td><input type='number' name='antiPassbackTime' min='0' max='65535' value='%u'></td></tr>"), basicConfig.antiPassbackTime);
+
+  responseWrite_P(PSTR("<tr class='section'><td colspan='2'>Sesion TCP (CrossChex)</td></tr>"));
+  responsePrintf(PSTR("<tr><td>Cerrar tras segundos sin comandos (0 = nunca)</td><td><input type='number' name='sessionIdleTimeout' min='0' max='65535' value='%u'></td></tr>"), basicConfig.sessionIdleTimeout);
+  responsePrintf(PSTR("<tr><td>Keepalive TCP: segundos sin trafico antes de sondear (0 = desactivado)</td><td><input type='number' name='keepAliveIdle' min='0' max='7200' value='%u'></td></tr>"), basicConfig.keepAliveIdle);
+  responsePrintf(PSTR("<tr><td>Maximo de tramas por peticion masiva (extension propia para middleware; CrossChex siempre recibe el protocolo estricto)</td><td><input type='number' name='bulkPages' min='1' max='40' value='%u'></td></tr>"), basicConfig.bulkPages);
+
+  responseWrite_P(PSTR("<tr class='section'><td colspan='2'>Envio a Colector</td></tr>"));
+  responsePrintf(PSTR("<tr><td>Enviar registros nuevos al colector</td><td><input type='checkbox' name='pushEnabled' %s></td></tr>"), pushConfig.enabled ? "checked" : "");
+  responsePrintf(PSTR("<tr><td>Formato</td><td><select name='pushMode'><option value='0'%s>TCP (tramas Anviz)</option><option value='1'%s>HTTP (JSON)</option></select></td></tr>"),
+                 pushConfig.mode == PUSH_TCP_ANVIZ ? " selected" : "", pushConfig.mode == PUSH_HTTP_JSON ? " selected" : "");
+  responsePrintf(PSTR("<tr><td>Servidor : puerto</td><td><input type='text' name='pushHost' maxlength='39' value='%s'> : <input type='number' name='pushPort' min='1' max='65535' value='%u'></td></tr>"), pushConfig.host, pushConfig.port);
+  responsePrintf(PSTR("<tr><td>Ruta (HTTP)</td><td><input type='text' name='pushPath' maxlength='39' value='%s'></td></tr>"), pushConfig.path);
+  responsePrintf(PSTR("<tr><td>Registros por lote</td><td><input type='number' name='pushBatch' min='1' max='25' value='%u'></td></tr>"), pushConfig.batchSize);
+
+  responseWrite_P(PSTR("<tr class='section'><td colspan='2'>MQTT</td></tr>"));
+  responsePrintf(PSTR("<tr><td>Publicar eventos y aceptar ordenes</td><td><input type='checkbox' name='mqttEnabled' %s></td></tr>"), mqttConfig.enabled ? "checked" : "");
+  responsePrintf(PSTR("<tr><td>Broker : puerto</td><td><input type='text' name='mqttHost' maxlength='39' value='%s'> : <input type='number' name='mqttPort' min='1' max='65535' value='%u'></td></tr>"), mqttConfig.host, mqttConfig.port);
+  responsePrintf(PSTR("<tr><td>Usuario / contrasena</td><td><input type='text' name='mqttUser' maxlength='32' value='%s'> / <input type='password' name='mqttPass' maxlength='32' placeholder='sin cambios'></td></tr>"), mqttConfig.user);
+  responsePrintf(PSTR("<tr><td>Prefijo de topics</td><td><input type='text' name='mqttPrefix' maxlength='31' value='%s'></td></tr>"), mqttConfig.prefix);
+
+  responseWrite_P(PSTR("<tr class='section'><td colspan='2'>Otros Parametros</td></tr>"));
+  responsePrintf(PSTR("<tr><td>Numero de serie</td><td>%s</td></tr>"), serialNumber);
+  responsePrintf(PSTR("<tr><td>Volumen</td><td>%d</td></tr>"), basicConfig.volume);
 
   const char* languageName;
   switch(basicConfig.language) {
@@ -286,8 +220,7 @@ void handleSettings() {
     case 5: languageName = "Portugues"; break;
     default: languageName = "Desconocido"; break;
   }
-  snprintf_P(buffer, sizeof(buffer), PSTR("<tr><td>Idioma</td><td>%s</td></tr>"), languageName);
-  webServer.sendContent(buffer);
+  responsePrintf(PSTR("<tr><td>Idioma</td><td>%s</td></tr>"), languageName);
 
   const char* dateFormatStr;
   uint8_t dateFormatType = (basicConfig.dateFormat >> 4) & 0x0F;
@@ -300,47 +233,159 @@ void handleSettings() {
   }
   char fullDateFormat[50];
   snprintf_P(fullDateFormat, sizeof(fullDateFormat), PSTR("%s, %s"), dateFormatStr, (timeFormatType == 0) ? "24 horas" : "12 horas (AM/PM)");
-  snprintf_P(buffer, sizeof(buffer), PSTR("<tr><td>Formato de fecha</td><td>%s</td></tr>"), fullDateFormat);
-  webServer.sendContent(buffer);
+  responsePrintf(PSTR("<tr><td>Formato de fecha</td><td>%s</td></tr>"), fullDateFormat);
 
   FSInfo fsInfo;
   if (SPIFFS.info(fsInfo)) {
-    snprintf_P(buffer, sizeof(buffer), PSTR("<tr><td>Espacio SPIFFS utilizado</td><td>%d / %d bytes</td></tr>"), fsInfo.usedBytes, fsInfo.totalBytes);
-    webServer.sendContent(buffer);
+    responsePrintf(PSTR("<tr><td>Espacio SPIFFS utilizado</td><td>%d / %d bytes</td></tr>"), fsInfo.usedBytes, fsInfo.totalBytes);
+  }
+
+  responseWrite_P(PSTR("</table><br><input type='submit' value='Guardar y Reiniciar'></form>"));
+  responseWrite_P(PSTR("<hr><p><a href='/changewifi' data-confirm='Esta seguro de querer cambiar la red WiFi? Se borrara la configuracion actual y el dispositivo se reiniciara en modo de configuracion.'>Cambiar Red WiFi</a></p></div>"));
+
+  sendPageFoot();
+}
+
+// Pagina de horarios de acceso por grupo
+void handleSchedule() {
+  if (!isAuthenticated()) return;
+
+  sendPageHead("Horarios - Emulador Anviz", "schedule", "Horarios de Acceso");
+  responseWrite_P(PSTR("<div class='status'><p>Cada regla permite el acceso a su grupo en los dias marcados, desde la hora inicial hasta la final (HH:MM, en franjas de 15 minutos; 24:00 = fin del dia). "
+                       "Los grupos sin ninguna regla, y los grupos 8 o superiores, pueden acceder a cualquier hora.</p></div>"
+                       "<form action='/saveschedule' method='post'><table><tr><th>Grupo</th><th>Dom</th><th>Lun</th><th>Mar</th><th>Mie</th><th>Jue</th><th>Vie</th><th>Sab</th><th>Festivo</th><th>Desde</th><th>Hasta</th><th>Borrar</th></tr>"));
+
+  // Reglas existentes y una fila vacía para añadir otra
+  int rows = (scheduleRuleCount < MAX_SCHEDULE_RULES) ? scheduleRuleCount + 1 : scheduleRuleCount;
+  for (int i = 0; i < rows; i++) {
+    bool isNew = (i == scheduleRuleCount);
+    const ScheduleRule& rule = scheduleRules[i];
+    if (isNew) {
+      responsePrintf(PSTR("<tr><td><input type='number' name='g%d' min='0' max='%d' placeholder='nuevo'></td>"), i, SCHEDULE_GROUPS - 1);
+    } else {
+      responsePrintf(PSTR("<tr><td><input type='number' name='g%d' min='0' max='%d' value='%u'></td>"), i, SCHEDULE_GROUPS - 1, rule.group);
+    }
+    for (int kind = 0; kind < 8; kind++) {
+      bool checked = isNew ? (kind >= 1 && kind <= 5) : (rule.days & (1 << kind));
+      responsePrintf(PSTR("<td><input type='checkbox' name='d%d_%d' %s></td>"), i, kind, checked ? "checked" : "");
+    }
+    uint8_t start = isNew ? 32 : rule.startSlot;  // Por defecto 08:00-18:00
+    uint8_t end = isNew ? 72 : rule.endSlot;
+    responsePrintf(PSTR("<td><input type='text' name='s%d' size='5' value='%02u:%02u'></td><td><input type='text' name='e%d' size='5' value='%02u:%02u'></td>"),
+                   i, start / 4, (start % 4) * 15, i, end / 4, (end % 4) * 15);
+    if (isNew) {
+      responseWrite_P(PSTR("<td></td></tr>"));
+    } else {
+      responsePrintf(PSTR("<td><input type='checkbox' name='del%d'></td></tr>"), i);
+    }
+  }
+  responsePrintf(PSTR("</table><input type='hidden' name='rows' value='%d'>"), rows);
+
+  responseWrite_P(PSTR("<h2>Festivos</h2><p>Una fecha por linea (YYYY-MM-DD). En estos dias se aplican las columnas \"Festivo\".</p><textarea name='holidays' rows='8' cols='14'>"));
+  for (int i = 0; i < holidayCount; i++) {
+    char dayText[12];
+    formatDayText(dayText, sizeof(dayText), holidays[i]);
+    responsePrintf(PSTR("%s\n"), dayText);
+  }
+  responseWrite_P(PSTR("</textarea><br><br><input type='submit' value='Guardar Horarios'></form>"));
+
+  sendPageFoot();
+}
+
+// Convertir "HH:MM" en una franja de 15 minutos. El final de una regla se
+// redondea hacia arriba para no recortar el acceso.
+bool parseSlotText(const String& text, bool roundUp, uint8_t& slot) {
+  int hour, minute;
+  if (sscanf(text.c_str(), "%d:%d", &hour, &minute) != 2 || hour < 0 || minute < 0 || minute > 59 ||
+      hour * 60 + minute > 24 * 60) {
+    return false;
+  }
+  int minutes = hour * 60 + minute;
+  slot = roundUp ? (minutes + 14) / 15 : minutes / 15;
+  return true;
+}
+
+// Manejar guardado de horarios
+void handleSaveSchedule() {
+  if (!isAuthenticated()) return;
+
+  int rows = webServer.arg("rows").toInt();
+  if (rows > MAX_SCHEDULE_RULES) rows = MAX_SCHEDULE_RULES;
+
+  ScheduleRule parsed[MAX_SCHEDULE_RULES];
+  int count = 0;
+  char name[12];
+  for (int i = 0; i < rows; i++) {
+    // Saltar filas marcadas para borrar o sin grupo (fila nueva vacía)
+    snprintf_P(name, sizeof(name), PSTR("del%d"), i);
+    if (webServer.hasArg(name)) continue;
+    snprintf_P(name, sizeof(name), PSTR("g%d"), i);
+    if (webServer.arg(name).length() == 0) continue;
+
+    ScheduleRule& rule = parsed[count];
+    long group = webServer.arg(name).toInt();
+    snprintf_P(name, sizeof(name), PSTR("s%d"), i);
+    bool validStart = parseSlotText(webServer.arg(name), false, rule.startSlot);
+    snprintf_P(name, sizeof(name), PSTR("e%d"), i);
+    bool validEnd = parseSlotText(webServer.arg(name), true, rule.endSlot);
+    if (group < 0 || group >= SCHEDULE_GROUPS || !validStart || !validEnd || rule.endSlot <= rule.startSlot) {
+      char message[80];
+      snprintf_P(message, sizeof(message), PSTR("Regla %d no valida: grupo 0-%d y hora final posterior a la inicial."), i + 1, SCHEDULE_GROUPS - 1);
+      webServer.send(400, "text/plain", message);
+      return;
+    }
+    rule.group = group;
+    rule.days = 0;
+    for (int kind = 0; kind < 8; kind++) {
+      snprintf_P(name, sizeof(name), PSTR("d%d_%d"), i, kind);
+      if (webServer.hasArg(name)) rule.days |= 1 << kind;
+    }
+    count++;
+  }
+
+  // Festivos: una fecha por línea (también se aceptan comas o espacios)
+  uint16_t parsedHolidays[MAX_HOLIDAYS];
+  int parsedHolidayCount = 0;
+  String text = webServer.arg("holidays");
+  int pos = 0;
+  while (pos < (int)text.length()) {
+    int next = pos;
+    while (next < (int)text.length() && !isspace(text[next]) && text[next] != ',') next++;
+    if (next > pos) {
+      uint16_t day;
+      if (!parseDayText(text.substring(pos, next).c_str(), day)) {
+        webServer.send(400, "text/plain", "Fecha de festivo no valida (use YYYY-MM-DD).");
+        return;
+      }
+      if (parsedHolidayCount < MAX_HOLIDAYS) parsedHolidays[parsedHolidayCount++] = day;
+    }
+    pos = next + 1;
   }
 
-  webServer.sendContent_P(PSTR("</table><br><input type='submit' value='Guardar y Reiniciar'></form>"));
-  webServer.sendContent_P(PSTR("<hr><p><a href='/changewifi' onclick='return confirm(\"Esta seguro de querer cambiar la red WiFi? Se borrara la configuracion actual y el dispositivo se reiniciara en modo de configuracion.\");'>Cambiar Red WiFi</a></p></div>"));
+  memcpy(scheduleRules, parsed, count * sizeof(ScheduleRule));
+  scheduleRuleCount = count;
+  memcpy(holidays, parsedHolidays, parsedHolidayCount * sizeof(uint16_t));
+  holidayCount = parsedHolidayCount;
+  compileSchedules();
+  saveSchedules();
 
-  // Send footer
-  webServer.sendContent_P(PSTR("</body></html>"));
-  webServer.sendContent(""); // Terminate the connection
+  webServer.sendHeader("Location", "/schedule");
+  webServer.send(303);
 }
 
 // Página para cambiar la autenticación
 void handleAuth() {
   if (!isAuthenticated()) return;
 
-  webServer.sendHeader("Content-Type", "text/html; charset=UTF-8");
-  webServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
-
-  // Send header
-  webServer.sendContent_P(PSTR("<!DOCTYPE html><html><head><title>Seguridad - Emulador Anviz</title>"));
-  webServer.sendContent_P(PSTR("<meta charset='UTF-8'><meta name='viewport' content='width=device-width, initial-scale=1'>"));
-  webServer.sendContent_P(PSTR("<style>body{font-family:Arial,sans-serif;margin:0;padding:20px;color:#333}h1{color:#0066cc}.menu{background-color:#f0f0f0;padding:10px;margin-bottom:20px}.menu a{margin-right:10px;color:#0066cc;text-decoration:none;padding:5px}.menu a:hover{background-color:#e0e0e0}.config{background-color:#f9f9f9;padding:15px;border-radius:5px}input[type=text],input[type=password]{width:100%;padding:8px;margin:4px 0;display:inline-block;border:1px solid #ccc;border-radius:4px;box-sizing:border-box}input[type=submit]{background-color:#0066cc;color:white;padding:10px 15px;border:none;border-radius:4px;cursor:pointer}</style>"));
-  webServer.sendContent_P(PSTR("</head><body><h1>Configuración de Seguridad</h1><div class='menu'><a href='/'>Inicio</a><a href='/users'>Usuarios</a><a href='/records'>Registros</a><a href='/settings'>Configuracion</a><a href='/auth'>Seguridad</a></div>"));
+  sendPageHead("Seguridad - Emulador Anviz", "auth", "Configuración de Seguridad");
 
   // Send form
-  char buffer[256];
-  webServer.sendContent_P(PSTR("<div class='config'><h2>Cambiar Credenciales de Acceso Web</h2><form action='/saveauth' method='post'>"));
-  webServer.sendContent_P(PSTR("<label for='user'>Usuario:</label>"));
-  snprintf_P(buffer, sizeof(buffer), PSTR("<input type='text' id='user' name='user' value='%s' required>"), web_user);
-  webServer.sendContent(buffer);
-  webServer.sendContent_P(PSTR("<label for='pass'>Nueva Contraseña:</label><input type='password' id='pass' name='pass' required><br><br><input type='submit' value='Guardar Credenciales'></form></div>"));
-
-  // Send footer
-  webServer.sendContent_P(PSTR("</body></html>"));
-  webServer.sendContent(""); // Terminate the connection
+  responseWrite_P(PSTR("<div class='config'><h2>Cambiar Credenciales de Acceso Web</h2><form action='/saveauth' method='post'>"));
+  responseWrite_P(PSTR("<label for='user'>Usuario:</label>"));
+  responsePrintf(PSTR("<input type='text' id='user' name='user' value='%s' required>"), web_user);
+  responseWrite_P(PSTR("<label for='pass'>Nueva Contraseña:</label><input type='password' id='pass' name='pass' required><br><br><input type='submit' value='Guardar Credenciales'></form></div>"));
+
+  sendPageFoot();
 }
 
 // Manejar guardado de configuracion
@@ -349,9 +394,27 @@ void handleSaveSettings() {
   if (webServer.hasArg("deviceId")) {
     deviceId = webServer.arg("deviceId").toInt();
   }
-  if (webServer.hasArg("pin_d0")) {
-    basicConfig.pin_d0 = webServer.arg("pin_d0").toInt();
-    basicConfig.pin_d1 = webServer.arg("pin_d1").toInt();
+  if (webServer.hasArg("pin_relay")) {
+    // Lectores: solo las filas con ambos pines; se conserva el actual si no queda ninguno
+    ReaderConfig readers[MAX_READERS];
+    uint8_t readerCount = 0;
+    for (int i = 0; i < MAX_READERS; i++) {
+      char name[8];
+      snprintf_P(name, sizeof(name), PSTR("r%d_d0"), i);
+      String d0 = webServer.arg(name);
+      snprintf_P(name, sizeof(name), PSTR("r%d_d1"), i);
+      String d1 = webServer.arg(name);
+      if (d0.length() == 0 || d1.length() == 0) continue;
+      snprintf_P(name, sizeof(name), PSTR("r%d_dir"), i);
+      readers[readerCount].pin_d0 = d0.toInt();
+      readers[readerCount].pin_d1 = d1.toInt();
+      readers[readerCount].direction = (webServer.arg(name).toInt() == 1) ? 1 : 0;
+      readerCount++;
+    }
+    if (readerCount > 0) {
+      memcpy(basicConfig.readers, readers, readerCount * sizeof(ReaderConfig));
+      basicConfig.readerCount = readerCount;
+    }
     basicConfig.pin_relay = webServer.arg("pin_relay").toInt();
     basicConfig.pin_led = webServer.arg("pin_led").toInt();
   }
@@ -359,6 +422,41 @@ void handleSaveSettings() {
     basicConfig.relayOnDuration = webServer.arg("relayOnDuration").toInt();
   }
 
+  if (webServer.hasArg("duplicateWindow")) {
+    basicConfig.duplicateWindow = webServer.arg("duplicateWindow").toInt();
+    basicConfig.antiPassbackTime = webServer.arg("antiPassbackTime").toInt();
+  }
+
+  if (webServer.hasArg("sessionIdleTimeout")) {
+    basicConfig.sessionIdleTimeout = webServer.arg("sessionIdleTimeout").toInt();
+    basicConfig.keepAliveIdle = webServer.arg("keepAliveIdle").toInt();
+    long bulkPages = webServer.arg("bulkPages").toInt();
+    basicConfig.bulkPages = (bulkPages < 1) ? 1 : (bulkPages > BULK_MAX_PAGES ? BULK_MAX_PAGES : bulkPages);
+  }
+
+  if (webServer.hasArg("pushHost")) {
+    pushConfig.enabled = webServer.hasArg("pushEnabled");
+    pushConfig.mode = (webServer.arg("pushMode").toInt() == PUSH_HTTP_JSON) ? PUSH_HTTP_JSON : PUSH_TCP_ANVIZ;
+    strlcpy(pushConfig.host, webServer.arg("pushHost").c_str(), sizeof(pushConfig.host));
+    pushConfig.port = webServer.arg("pushPort").toInt();
+    strlcpy(pushConfig.path, webServer.arg("pushPath").c_str(), sizeof(pushConfig.path));
+    long batch = webServer.arg("pushBatch").toInt();
+    pushConfig.batchSize = (batch < 1) ? 1 : (batch > 25 ? 25 : batch);
+    savePushConfig();
+  }
+
+  if (webServer.hasArg("mqttHost")) {
+    mqttConfig.enabled = webServer.hasArg("mqttEnabled");
+    strlcpy(mqttConfig.host, webServer.arg("mqttHost").c_str(), sizeof(mqttConfig.host));
+    mqttConfig.port = webServer.arg("mqttPort").toInt();
+    strlcpy(mqttConfig.user, webServer.arg("mqttUser").c_str(), sizeof(mqttConfig.user));
+    if (webServer.arg("mqttPass").length() > 0) {
+      strlcpy(mqttConfig.pass, webServer.arg("mqttPass").c_str(), sizeof(mqttConfig.pass));
+    }
+    strlcpy(mqttConfig.prefix, webServer.arg("mqttPrefix").c_str(), sizeof(mqttConfig.prefix));
+    saveMqttConfig();
+  }
+
   // Guardar configuración de reinicio
   basicConfig.rebootEnabled = webServer.hasArg("rebootEnabled");
   if (webServer.hasArg("rebootHour")) {
@@ -403,8 +501,7 @@ void handleWifiChange() {
 // Manejar borrado de registros
 void handleClearLogs() {
   if (!isAuthenticated()) return;
-  recordCount = 0;
-  newRecordCount = 0;
+  clearRecords();
   saveRecords();
   
   webServer.sendHeader("Location", "/records");
@@ -420,38 +517,35 @@ void handleReset() {
   ESP.restart();
 }
 
-// Manejar carga de archivos
+// Manejar carga de archivos: importación de usuarios (CSV o JSON) trozo a
+// trozo, sin guardar el archivo (importacion.h)
 void handleFileUpload() {
   if (!isAuthenticated()) return;
   HTTPUpload& upload = webServer.upload();
   
   if (upload.status == UPLOAD_FILE_START) {
-    String filename = "/upload_" + upload.filename;
-    Serial.println("Iniciando carga: " + filename);
-    
-    File file = SPIFFS.open(filename, "w");
-    if (!file) {
-      Serial.println("Error al abrir el archivo para escritura");
-      return;
-    }
-    
-    uploadFile = file;
+    Serial.println("Iniciando importacion: " + upload.filename);
+    beginUserImport(upload.filename);
   }
   else if (upload.status == UPLOAD_FILE_WRITE) {
-    if (uploadFile) {
-      uploadFile.write(upload.buf, upload.currentSize);
-    }
+    feedUserImport(upload.buf, upload.currentSize);
   }
   else if (upload.status == UPLOAD_FILE_END) {
-    if (uploadFile) {
-      uploadFile.close();
-      Serial.println("Carga completada: " + String(upload.totalSize) + " bytes");
-    }
+    endUserImport();
+    Serial.println("Importacion completada: " + String(upload.totalSize) + " bytes, " + String(userImport.rows) + " filas");
   }
   else if (upload.status == UPLOAD_FILE_ABORTED) {
     Serial.println("Carga abortada");
-    if (uploadFile) {
-      uploadFile.close();
-    }
+    abortUserImport();
   }
+}
+
+// Resumen de la importación al terminar la subida
+void handleUploadDone() {
+  if (!isAuthenticated()) return;
+  char json[192];
+  snprintf_P(json, sizeof(json), PSTR("{\"rows\":%u,\"added\":%u,\"updated\":%u,\"unchanged\":%u,\"rejected\":%u,\"full\":%u}"),
+             userImport.rows, userImport.added, userImport.updated, userImport.unchanged,
+             userImport.rejected, userImport.full);
+  webServer.send(200, "application/json", json);
 }
\ No newline at end of file
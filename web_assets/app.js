@@ -0,0 +1,128 @@
+// Interfaz web del emulador Anviz: las páginas son plantillas mínimas y los
+// datos se piden a la API JSON (/api/*) y al canal de eventos (/events).
+(function () {
+  'use strict';
+
+  function $(id) { return document.getElementById(id); }
+
+  function esc(text) {
+    return String(text).replace(/[&<>"']/g, function (c) {
+      return '&#' + c.charCodeAt(0) + ';';
+    });
+  }
+
+  function getJson(url) {
+    return fetch(url, { credentials: 'same-origin' }).then(function (r) {
+      if (!r.ok) throw new Error(r.status);
+      return r.json();
+    });
+  }
+
+  function row(cells, cls) {
+    var tr = document.createElement('tr');
+    if (cls) tr.className = cls;
+    tr.innerHTML = cells.map(function (c) { return '<td>' + esc(c) + '</td>'; }).join('');
+    return tr;
+  }
+
+  function fail(el) {
+    return function (e) { el.textContent = 'Error al cargar datos (' + e.message + ')'; };
+  }
+
+  var METHODS = { 1: 'Contrasena', 2: 'Huella digital', 8: 'Tarjeta' };
+
+  function method(backup) { return METHODS[backup] || 'Otro'; }
+
+  // Bits bajos del tipo de registro: 0 = entrada, 1 = salida (bit 7 = acceso correcto)
+  function direction(type) { return ((type & 0x7F) === 1) ? 'Salida' : 'Entrada'; }
+
+  // Confirmación de enlaces con acciones destructivas (data-confirm)
+  document.addEventListener('click', function (e) {
+    var a = e.target.closest('a[data-confirm]');
+    if (a && !confirm(a.getAttribute('data-confirm'))) e.preventDefault();
+  });
+
+  var pages = {};
+
+  // Página principal: estado y perfil de memoria
+  pages.status = function () {
+    getJson('/api/status').then(function (s) {
+      var mb = 1024 * 1024;
+      var items = [
+        ['Direccion IP', s.ip],
+        ['Fuerza de senal WiFi', s.rssi + ' dBm'],
+        ['SSID', s.ssid],
+        ['RAM Libre', (s.heap / 1024).toFixed(2) + ' KB'],
+        ['Flash (SPIFFS) Libre', (s.fsFree / mb).toFixed(2) + ' / ' + (s.fsTotal / mb).toFixed(2) + ' MB'],
+        ['Usuarios registrados', s.users],
+        ['Registros de acceso', s.records + ' (nuevos: ' + s.newRecords + ')'],
+        ['Fecha y hora', s.time]
+      ];
+      $('status').innerHTML = items.map(function (i) {
+        return '<p>' + esc(i[0]) + ': ' + esc(i[1]) + '</p>';
+      }).join('');
+      var mem = $('mem');
+      s.mem.forEach(function (p) {
+        mem.appendChild(row([p.op, p.heap + ' B', p.block + ' B', p.frag + ' %', p.stack + ' B', p.samples]));
+      });
+    }).catch(fail($('status')));
+  };
+
+  // Página de usuarios: paginada por cursor
+  pages.users = function () {
+    var table = $('users');
+    var more = $('more');
+    var cursor = '';
+    function load() {
+      more.hidden = true;
+      getJson('/api/users?limit=50&cursor=' + cursor).then(function (r) {
+        r.users.forEach(function (u) {
+          table.appendChild(row([u.id, u.name, u.card, u.dept, u.active ? 'Activo' : 'Inactivo']));
+        });
+        if (r.total === 0) $('msg').textContent = 'No hay usuarios registrados. Utilice el software Anviz CrossChex para anadir usuarios.';
+        if (r.next !== null) { cursor = r.next; more.hidden = false; }
+      }).catch(fail($('msg')));
+    }
+    more.onclick = load;
+    load();
+  };
+
+  // Página de registros: últimos 50 y nuevos accesos en vivo
+  pages.records = function () {
+    var table = $('records');
+    var first = table.rows[0];
+    function prepend(tr) { table.insertBefore(tr, first.nextSibling); }
+    getJson('/api/status').then(function (s) {
+      var cursor = Math.max(s.firstSeq, s.nextSeq - 50);
+      if (s.records === 0) $('msg').textContent = 'No hay registros de acceso. Los registros se generaran cuando los usuarios utilicen sus tarjetas.';
+      else if (s.records > 50) $('msg').textContent = 'Mostrando los ultimos 50 registros de un total de ' + s.records + '.';
+      return getJson('/api/records?limit=50&cursor=' + cursor);
+    }).then(function (r) {
+      r.records.forEach(function (rec) {
+        prepend(row([rec.user, rec.name || '', rec.time, direction(rec.type), method(rec.backup)]));
+      });
+    }).catch(fail($('msg')));
+
+    if (!window.EventSource) return;
+    var events = new EventSource('/events');
+    events.addEventListener('access', function (e) {
+      var ev = JSON.parse(e.data);
+      var when = new Date(ev.ts * 1000).toISOString().replace('T', ' ').substr(0, 19);
+      if (ev.r === 'grant') {
+        prepend(row([ev.user, ev.name, when, direction(ev.type), 'Tarjeta'], 'new'));
+      } else if (ev.r === 'schedule' || ev.r === 'passback') {
+        var reason = ev.r === 'schedule' ? ' (fuera de horario)' : ' (anti-passback)';
+        prepend(row([ev.user, ev.name + reason, when, '-', 'Tarjeta'], 'deny'));
+      } else if (ev.r === 'unlock') {
+        prepend(row(['-', 'Apertura remota', when, '-', '-'], 'new'));
+      } else {
+        prepend(row(['-', 'Tarjeta ' + ev.card + ' denegada', when, '-', 'Tarjeta'], 'deny'));
+      }
+    });
+  };
+
+  document.addEventListener('DOMContentLoaded', function () {
+    var page = pages[document.body.getAttribute('data-page')];
+    if (page) page();
+  });
+})();